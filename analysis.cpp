@@ -0,0 +1,320 @@
+/*------------------------------------------------------------------------------
+Analysis server: best move and win rate of positions, for a long running process
+analysis.cpp
+------------------------------------------------------------------------------*/
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "analysis.hpp"
+#include "moveeval.hpp"
+#include "protocolio.hpp"
+
+using namespace std;
+
+// Parse the decimal number at the start of text, up to UINT_MAX. Return the
+// number of digits, 0 if there is no number or it is too large.
+static size_t number_parse(const char* text, unsigned& value)
+{
+    unsigned long n = 0;
+    size_t nb_digits = 0;
+    while (isdigit(text[nb_digits])) {
+        n = 10 * n + (text[nb_digits++] - '0');
+        if (n > UINT_MAX) {
+            return 0;
+        }
+    }
+    value = n;
+    return nb_digits;
+}
+
+// Column letters as in spreadsheets, for the boards of more than 26 columns:
+// a to z, then aa, ab... Parse those at the start of text into col, return the
+// number of letters, 0 if there are none or too many.
+static size_t column_parse(const char* text, unsigned& col)
+{
+    unsigned long n = 0;
+    size_t nb_letters = 0;
+    while (isalpha(static_cast<unsigned char>(text[nb_letters]))) {
+        n = 26 * n
+            + (tolower(static_cast<unsigned char>(text[nb_letters++])) - 'a'
+               + 1);
+        if (n > hexboard_max_size) {
+            return 0;
+        }
+    }
+    col = n - 1;
+    return nb_letters;
+}
+
+static string column_name(const unsigned col)
+{
+    string name;
+    for (unsigned n = col + 1; n > 0; n = (n - 1) / 26) {
+        name.insert(name.begin(), static_cast<char>('a' + (n - 1) % 26));
+    }
+    return name;
+}
+
+AnalysisServer::AnalysisServer():
+    nb_threads(1), engine(EngineType::FLAT_MC),
+    uct_parallel(UctParallel::TREE), amaf(false),
+    playout_policy(PlayoutPolicy::UNIFORM), inferior_slots(false),
+    seeded(false), seed(0), sizes(hexboard_max_size + 1)
+{
+}
+
+void AnalysisServer::random_seed(const mt19937::result_type new_seed)
+{
+    seeded = true;
+    seed = new_seed;
+}
+
+void AnalysisServer::transposition_table_size_set(const size_t megabytes)
+{
+    if (megabytes == 0) {
+        transpositions.reset();
+    } else {
+        transpositions.reset(new TranspositionTable(megabytes));
+    }
+}
+
+string AnalysisServer::request_answer(const string& request)
+{
+    istringstream tokens(request);
+    unsigned size = 0;
+    string player_token;
+    string budget;
+    if (!(tokens >> size >> player_token >> budget)) {
+        return "? expecting: size player budget [stones]";
+    }
+    if ((size < 3) || (size > hexboard_max_size)) {
+        return "? board size must be 3 to " + to_string(hexboard_max_size);
+    }
+    if ((player_token != "X") && (player_token != "O")) {
+        return "? player must be X or O: " + player_token;
+    }
+    const Player to_move(player_token == "X" ? player_e::X : player_e::O);
+
+    // Iterations per test move, or milliseconds.
+    unsigned amount = 0;
+    const size_t nb_digits = number_parse(budget.c_str(), amount);
+    const string unit = budget.substr(nb_digits);
+    if ((amount == 0) || (!unit.empty() && (unit != "ms"))) {
+        return "? budget must be iterations or milliseconds (ms): " + budget;
+    }
+    const bool timed = !unit.empty();
+
+    vector<player_e> stones(size * size, player_e::NONE);
+    string stone;
+    while (tokens >> stone) {
+        const char color = stone[0];
+        unsigned col = 0;
+        const size_t nb_letters = column_parse(stone.c_str() + 1, col);
+        unsigned row = 0;
+        const size_t row_start = 1 + nb_letters;
+        const bool row_read = (nb_letters > 0) && (stone.size() > row_start)
+            && (number_parse(stone.c_str() + row_start, row)
+                == stone.size() - row_start);
+        if (((color != 'X') && (color != 'O')) || (col >= size)
+            || !row_read || (row == 0) || (row > size)) {
+            return "? illegal stone: " + stone;
+        }
+        --row;
+        if (stones[row * size + col] != player_e::NONE) {
+            return "? slot played twice: " + stone;
+        }
+        stones[row * size + col] = (color == 'X') ? player_e::X : player_e::O;
+    }
+
+    SizeState& state = size_state_get(size);
+    position_set(state, stones, to_move);
+    HexBoard& board = *state.board;
+    if (board.win_check(Player(player_e::X))
+        || board.win_check(Player(player_e::O))) {
+        return "? the game is over";
+    }
+
+    chrono::steady_clock::time_point deadline
+        = chrono::steady_clock::time_point::max();
+    unsigned simulations_per_test_move = amount;
+    if (timed) {
+        deadline = chrono::steady_clock::now() + chrono::milliseconds(amount);
+        simulations_per_test_move = UINT_MAX;
+    }
+
+    if (transpositions) {
+        transpositions->generation_next();
+    }
+    pair<unsigned, unsigned> move;
+    double score;
+    if (engine == EngineType::UCT) {
+        UctSearch& search = *state.search;
+        search.simulations_set(UINT_MAX, simulations_per_test_move);
+        search.deadline_set(deadline);
+        search.threads_set(nb_threads);
+        search.parallel_set(uct_parallel);
+        move = search.best_move_calculate();
+        score = search.best_score_get();
+    } else {
+        MoveEvaluator evaluator(board, to_move, UINT_MAX,
+                                simulations_per_test_move, nb_threads);
+        if (engine == EngineType::FLAT_MC_HALVING) {
+            evaluator.strategy_set(EvalStrategy::SUCCESSIVE_HALVING);
+        }
+        evaluator.amaf_set(amaf);
+        evaluator.transposition_table_set(transpositions.get());
+        evaluator.deadline_set(deadline);
+        move = evaluator.best_move_calculate();
+        score = evaluator.best_score_get();
+    }
+
+    char answer[32];
+    snprintf(answer, sizeof(answer), "= %s%u %.3f",
+             column_name(move.first).c_str(), move.second + 1, score);
+    return answer;
+}
+
+bool AnalysisServer::serve(const int in_fd, const int out_fd)
+{
+    ProtocolReader reader(in_fd);
+    ProtocolWriter writer(out_fd);
+    string line;
+    while (reader.line_read(line) == ProtocolRead::LINE) {
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == string::npos) {
+            continue;
+        }
+        const size_t last = line.find_last_not_of(" \t\r");
+        line = line.substr(first, last - first + 1);
+        if (line == "quit") {
+            return true;
+        }
+        writer << request_answer(line).c_str() << '\n';
+        if (!writer.flush()) {
+            // The client is gone.
+            return false;
+        }
+    }
+    return false;
+}
+
+bool AnalysisServer::socket_serve(const string& path)
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    strcpy(address.sun_path, path.c_str());
+
+    // A socket file left by a previous server, but no other kind of file.
+    struct stat status;
+    if (lstat(path.c_str(), &status) == 0) {
+        if (!S_ISSOCK(status.st_mode) || (unlink(path.c_str()) < 0)) {
+            return false;
+        }
+    }
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        return false;
+    }
+    if ((bind(listener, reinterpret_cast<struct sockaddr*>(&address),
+              sizeof(address)) < 0)
+        || (listen(listener, 4) < 0)) {
+        close(listener);
+        return false;
+    }
+    // A client leaving before its answer must not end the server.
+    signal(SIGPIPE, SIG_IGN);
+
+    bool quit = false;
+    while (!quit) {
+        const int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        quit = serve(client, client);
+        close(client);
+    }
+    close(listener);
+    unlink(path.c_str());
+    return true;
+}
+
+AnalysisServer::SizeState& AnalysisServer::size_state_get(const unsigned size)
+{
+    unique_ptr<SizeState>& state = sizes[size];
+    if (!state) {
+        state.reset(new SizeState(seeded ? new HexBoard(size, seed + size)
+                                  : new HexBoard(size)));
+        state->board->playout_policy_select(playout_policy);
+        state->board->inferior_slots_use(inferior_slots);
+        state->stones.assign(size * size, player_e::NONE);
+    }
+    return *state;
+}
+
+void AnalysisServer::position_set(SizeState& state,
+                                  const vector<player_e>& stones,
+                                  const Player to_move)
+{
+    HexBoard& board = *state.board;
+    const unsigned size = board.size_get();
+
+    // The tree of the previous search still holds if the position is the
+    // same, or if the player it searched for played one stone since.
+    unsigned nb_changes = 0;
+    unsigned new_stone = 0;
+    for (unsigned i = 0; i < stones.size(); ++i) {
+        if (stones[i] != state.stones[i]) {
+            ++nb_changes;
+            new_stone = i;
+        }
+    }
+    const bool same = (nb_changes == 0)
+        && (state.search_player.get() == to_move.get());
+    const bool next = (nb_changes == 1)
+        && (state.stones[new_stone] == player_e::NONE)
+        && (stones[new_stone] == state.search_player.get())
+        && (state.search_player.get() != to_move.get());
+
+    // Removed stones first, a slot may change player.
+    for (unsigned i = 0; i < stones.size(); ++i) {
+        if ((stones[i] != state.stones[i])
+            && (state.stones[i] != player_e::NONE)) {
+            board.unplace(i % size, i / size);
+        }
+    }
+    for (unsigned i = 0; i < stones.size(); ++i) {
+        if ((stones[i] != state.stones[i]) && (stones[i] != player_e::NONE)) {
+            board.place(i % size, i / size, Player(stones[i]));
+        }
+    }
+    state.stones = stones;
+
+    if (engine != EngineType::UCT) {
+        return;
+    }
+    if (state.search && next) {
+        state.search->advance(make_pair(new_stone % size, new_stone / size));
+    } else if (!state.search || !same) {
+        state.search.reset(new UctSearch(board, to_move));
+        state.search->transposition_table_set(transpositions.get());
+    }
+    state.search_player = to_move;
+}
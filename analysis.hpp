@@ -0,0 +1,106 @@
+/*------------------------------------------------------------------------------
+Analysis server: best move and win rate of positions, for a long running process
+analysis.hpp
+------------------------------------------------------------------------------*/
+#ifndef ANALYSIS_HPP_INCLUDED
+#define ANALYSIS_HPP_INCLUDED
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "hexboard.hpp"
+#include "hexgame.hpp"
+#include "player.hpp"
+#include "transposition.hpp"
+#include "uctsearch.hpp"
+
+// Answers requests of one line each, e.g. "11 X 200ms Xf6 Oe7":
+// - the board size,
+// - the player to move, X or O,
+// - the budget: n Monte-Carlo iterations per test move, or "nms" for n
+//   milliseconds,
+// - the stones on the board, in the notation of the automatic play
+//   protocol: player, column letters, row number. The columns after z are
+//   aa, ab... as in spreadsheets, e.g. "Xab30".
+// The answer is "= " followed by the best move and its win rate for the
+// player to move, e.g. "= e6 0.583", or "? " followed by an error message.
+//
+// The process stays up between the requests, and so does its state: one
+// board per size, the stones of which are only changed by the difference
+// between positions, the transposition table, and the tree of the last UCT
+// search. That tree is kept when the next request is the same position, or
+// the position one move later.
+class AnalysisServer {
+public:
+    AnalysisServer();
+
+    // Settings of the engine, as those of HexGame. Before the first
+    // request.
+    void threads_set(const unsigned n) {
+        nb_threads = n;
+    }
+    void engine_set(const EngineType e) {
+        engine = e;
+    }
+    void uct_parallel_set(const UctParallel mode) {
+        uct_parallel = mode;
+    }
+    void amaf_set(const bool enable) {
+        amaf = enable;
+    }
+    void playout_policy_set(const PlayoutPolicy policy) {
+        playout_policy = policy;
+    }
+    void inferior_slots_use(const bool enable) {
+        inferior_slots = enable;
+    }
+    void random_seed(const mt19937::result_type seed);
+    void transposition_table_size_set(const size_t megabytes);
+
+    // Answer of a request line, without '\n'.
+    string request_answer(const string& request);
+
+    // Answer the requests read on in_fd, on out_fd, until the input is
+    // closed or the request "quit". Return true on "quit".
+    bool serve(const int in_fd, const int out_fd);
+
+    // Listen on a Unix domain socket at path, and serve the clients one after
+    // the other until one of them sends "quit". A socket file already at path
+    // is replaced. Return false if the socket cannot be set up, or path is
+    // another kind of file.
+    bool socket_serve(const string& path);
+
+protected:
+    // Warm state of a board size.
+    struct SizeState {
+        explicit SizeState(HexBoard* board): board(board) {}
+        unique_ptr<HexBoard> board;
+        // Stones on board, indexed by row * size + col.
+        vector<player_e> stones;
+        // Tree of the last UCT search, and the player it searched for.
+        unique_ptr<UctSearch> search;
+        Player search_player;
+    };
+
+    unsigned nb_threads;
+    EngineType engine;
+    UctParallel uct_parallel;
+    bool amaf;
+    PlayoutPolicy playout_policy;
+    bool inferior_slots;
+    bool seeded;
+    mt19937::result_type seed;
+    unique_ptr<TranspositionTable> transpositions;
+    // Indexed by board size, created at the first request of that size.
+    vector< unique_ptr<SizeState> > sizes;
+
+    SizeState& size_state_get(const unsigned size);
+    // Put stones on the board of state, by difference with the previous
+    // position. Keep the tree of the UCT search if it leads to the new
+    // position for to_move, else drop it.
+    void position_set(SizeState& state, const vector<player_e>& stones,
+                      const Player to_move);
+};
+
+#endif // ANALYSIS_HPP_INCLUDED
@@ -0,0 +1,82 @@
+/*----------------------------------------------------------------------------
+Benchmark: UctSearch against MoveEvaluator at equal playout counts
+----------------------------------------------------------------------------*/
+
+// Modules under benchmark
+#include "../moveeval.hpp"
+#include "../uctsearch.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+#include "../hexboard.hpp"
+
+using namespace std;
+
+//******************************************************************************
+// Function prototypes
+//******************************************************************************
+void bench_engine_match(const unsigned size, const unsigned nb_games,
+                        const unsigned simulations_per_test);
+static bool game_play_uct_wins(const unsigned size, const Player uct_player,
+                               const unsigned simulations_per_test,
+                               const unsigned seed);
+
+// Usage: engine_match_bench [number of games] [simulations per test move]
+int main(int argc, char *argv[])
+{
+    unsigned nb_games = 20;
+    unsigned simulations_per_test = 200;
+    if (argc > 1) {
+        nb_games = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        simulations_per_test = atoi(argv[2]);
+    }
+
+    bench_engine_match(7, nb_games, simulations_per_test);
+    return 0;
+}
+
+// Play nb_games, UCT takes X every other game.
+void bench_engine_match(const unsigned size, const unsigned nb_games,
+                        const unsigned simulations_per_test)
+{
+    cout << __func__ << ", board " << size << "x" << size << ", "
+         << simulations_per_test << " simulations per test move" << endl;
+
+    unsigned uct_wins = 0;
+    for (unsigned game = 0; game < nb_games; ++game) {
+        Player uct_player((game % 2 == 0) ? player_e::X : player_e::O);
+        if (game_play_uct_wins(size, uct_player, simulations_per_test, game)) {
+            ++uct_wins;
+        }
+    }
+    cout << "uct: " << uct_wins << " wins, flat: " << nb_games - uct_wins
+         << " wins" << endl;
+}
+
+static bool game_play_uct_wins(const unsigned size, const Player uct_player,
+                               const unsigned simulations_per_test,
+                               const unsigned seed)
+{
+    HexBoard board(size);
+    board.random_seed(seed);
+    Player player(player_e::X);
+
+    for (;;) {
+        pair<unsigned, unsigned> move;
+        if (player == uct_player) {
+            UctSearch search(board, player, UINT_MAX, simulations_per_test);
+            move = search.best_move_calculate();
+        } else {
+            MoveEvaluator evaluator(board, player, UINT_MAX,
+                                    simulations_per_test);
+            move = evaluator.best_move_calculate();
+        }
+        if (board.play(move, player)) {
+            return player == uct_player;
+        }
+        player.swap();
+    }
+}
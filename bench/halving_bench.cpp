@@ -0,0 +1,165 @@
+/*----------------------------------------------------------------------------
+Benchmark: move quality of MoveEvaluator, uniform against successive halving,
+with and without AMAF, at equal playout counts
+----------------------------------------------------------------------------*/
+
+// Module under benchmark
+#include "../moveeval.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../hexboard.hpp"
+
+using namespace std;
+
+//******************************************************************************
+// Module variables
+//******************************************************************************
+static const Player player_X(player_e::X);
+
+// Playouts per test move of the reference evaluation of the positions.
+static const unsigned reference_playouts = 4000;
+
+//******************************************************************************
+// Function prototypes
+//******************************************************************************
+void bench_halving(const unsigned size, const unsigned nb_positions,
+                   const unsigned nb_seeds);
+static HexBoard position_make(const unsigned size, const unsigned seed);
+static vector<double> reference_rates(const HexBoard& position,
+                                      const vector< pair<unsigned, unsigned> >&
+                                      moves);
+
+// Usage: halving_bench [number of positions] [number of seeds per position]
+int main(int argc, char *argv[])
+{
+    unsigned nb_positions = 20;
+    unsigned nb_seeds = 5;
+    if (argc > 1) {
+        nb_positions = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        nb_seeds = atoi(argv[2]);
+    }
+
+    for (unsigned size: {7, 9}) {
+        bench_halving(size, nb_positions, nb_seeds);
+    }
+    return 0;
+}
+
+// The win rate of every move of the positions is estimated first, with many
+// playouts. The quality of a move picked by an evaluator is then its regret:
+// how much lower its reference win rate is than that of the best move. All
+// the settings get the same total number of playouts, for several budgets.
+void bench_halving(const unsigned size, const unsigned nb_positions,
+                   const unsigned nb_seeds)
+{
+    cout << __func__ << ", board " << size << "x" << size << ", "
+         << nb_positions << " positions, " << nb_seeds << " seeds each" << endl;
+    cout << setw(12) << "playouts" << setw(16) << "strategy"
+         << setw(10) << "regret" << setw(12) << "best move" << endl;
+
+    static const char* config_names[] = {
+        "uniform", "halving", "uniform+amaf", "halving+amaf"
+    };
+
+    vector<HexBoard> positions;
+    vector< vector< pair<unsigned, unsigned> > > moves;
+    vector< vector<double> > rates;
+    for (unsigned p = 0; p < nb_positions; ++p) {
+        positions.push_back(position_make(size, p));
+        moves.push_back(positions.back().unoccupied_list_get());
+        rates.push_back(reference_rates(positions.back(), moves.back()));
+    }
+
+    for (unsigned per_test: {20, 50, 100, 200}) {
+        for (unsigned config = 0; config < 4; ++config) {
+            const EvalStrategy strategy = (config % 2 == 0) ?
+                EvalStrategy::UNIFORM : EvalStrategy::SUCCESSIVE_HALVING;
+            const bool amaf = (config >= 2);
+            double regret = 0.0;
+            unsigned nb_best = 0;
+            unsigned long nb_playouts = 0;
+            for (unsigned p = 0; p < nb_positions; ++p) {
+                const double best_rate
+                    = *max_element(rates[p].begin(), rates[p].end());
+                for (unsigned seed = 0; seed < nb_seeds; ++seed) {
+                    HexBoard board(positions[p]);
+                    MoveEvaluator evaluator(board, player_X, UINT_MAX,
+                                            per_test, 1, seed);
+                    evaluator.strategy_set(strategy);
+                    evaluator.amaf_set(amaf);
+                    pair<unsigned, unsigned> move
+                        = evaluator.best_move_calculate();
+                    nb_playouts += evaluator.nb_simulations_get();
+
+                    const unsigned i = find(moves[p].begin(), moves[p].end(),
+                                            move) - moves[p].begin();
+                    regret += best_rate - rates[p][i];
+                    if (rates[p][i] == best_rate) {
+                        ++nb_best;
+                    }
+                }
+            }
+            const unsigned nb_runs = nb_positions * nb_seeds;
+            cout << setw(12) << nb_playouts / nb_runs
+                 << setw(16) << config_names[config]
+                 << fixed << setprecision(4)
+                 << setw(10) << regret / nb_runs
+                 << setw(11) << setprecision(1)
+                 << 100.0 * nb_best / nb_runs << "%" << endl;
+        }
+    }
+}
+
+// A few stones played at random by both players, X to play, no winner yet.
+static HexBoard position_make(const unsigned size, const unsigned seed)
+{
+    HexBoard board(size, seed);
+    mt19937 engine(seed);
+    Player player(player_e::X);
+
+    for (unsigned i = 0; i < 2 * (size / 2); ++i) {
+        vector< pair<unsigned, unsigned> > free_slots
+            = board.unoccupied_list_get();
+        shuffle(free_slots.begin(), free_slots.end(), engine);
+        for (auto move: free_slots) {
+            if (!board.play(move, player)) {
+                break;
+            }
+            board.unplace(move);
+        }
+        player.swap();
+    }
+    return board;
+}
+
+// Win rate of X after each move, with reference_playouts playouts.
+static vector<double> reference_rates(const HexBoard& position,
+                                      const vector< pair<unsigned, unsigned> >&
+                                      moves)
+{
+    vector<double> rates;
+    HexBoard board(position);
+    board.random_seed(12345);
+    board.player_select(player_X);
+    for (auto move: moves) {
+        board.place(move, player_X);
+        board.occupied_save();
+        unsigned wins = 0;
+        for (unsigned i = 0; i < reference_playouts; ++i) {
+            wins += board.fill_up_half_and_win_check();
+            board.occupied_restore();
+        }
+        board.unplace(move);
+        rates.push_back(static_cast<double>(wins) / reference_playouts);
+    }
+    return rates;
+}
@@ -0,0 +1,115 @@
+/*----------------------------------------------------------------------------
+Benchmark for the class MoveEvaluator
+----------------------------------------------------------------------------*/
+
+// Module under benchmark
+#include "../moveeval.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "../hexboard.hpp"
+
+using namespace std;
+
+//******************************************************************************
+// Module variables
+//******************************************************************************
+static const Player player_X(player_e::X);
+
+//******************************************************************************
+// Function prototypes
+//******************************************************************************
+void bench_moveeval_threads_scaling(const unsigned size,
+                                    const unsigned max_nb_threads);
+void bench_moveeval_symmetry(const unsigned size);
+
+// Usage: moveeval_bench [max number of threads]
+int main(int argc, char *argv[])
+{
+    unsigned max_nb_threads = thread::hardware_concurrency();
+    if (argc > 1) {
+        max_nb_threads = atoi(argv[1]);
+    }
+    if (max_nb_threads == 0) {
+        max_nb_threads = 1;
+    }
+
+    bench_moveeval_threads_scaling(11, max_nb_threads);
+    bench_moveeval_symmetry(11);
+    return 0;
+}
+
+// Playouts per second of a full best_move_calculate() on an empty board, from
+// one thread to max_nb_threads.
+void bench_moveeval_threads_scaling(const unsigned size,
+                                    const unsigned max_nb_threads)
+{
+    cout << __func__ << ", board " << size << "x" << size << endl;
+    cout << setw(8) << "threads" << setw(14) << "playouts/s"
+         << setw(10) << "speedup" << endl;
+
+    double single_thread_rate = 0.0;
+    // Powers of two, and max_nb_threads itself.
+    for (unsigned nb_threads = 1; ;
+         nb_threads = min(2 * nb_threads, max_nb_threads)) {
+        HexBoard board(size);
+        board.random_seed(1);
+        MoveEvaluator evaluator(board, player_X, 121 * 2000, 2000, nb_threads);
+
+        chrono::time_point<chrono::steady_clock> start, end;
+        start = chrono::steady_clock::now();
+        evaluator.best_move_calculate();
+        end = chrono::steady_clock::now();
+        chrono::duration<double> elapsed_seconds = end - start;
+
+        double rate = evaluator.nb_simulations_get() / elapsed_seconds.count();
+        if (nb_threads == 1) {
+            single_thread_rate = rate;
+        }
+        cout << setw(8) << nb_threads << setw(14) << static_cast<long>(rate)
+             << setw(10) << fixed << setprecision(2)
+             << rate / single_thread_rate << endl;
+
+        if (nb_threads == max_nb_threads) {
+            break;
+        }
+    }
+}
+
+// Time of the first move on an empty board, with and without skipping the
+// rotations of the test moves. Same number of simulations per test move.
+void bench_moveeval_symmetry(const unsigned size)
+{
+    cout << __func__ << ", board " << size << "x" << size << endl;
+    cout << setw(10) << "symmetry" << setw(12) << "playouts"
+         << setw(10) << "ms" << endl;
+
+    double time_all = 0.0;
+    for (bool symmetry: {false, true}) {
+        HexBoard board(size);
+        MoveEvaluator evaluator(board, player_X, size * size * 2000, 2000, 1,
+                                1);
+        evaluator.symmetry_set(symmetry);
+
+        chrono::time_point<chrono::steady_clock> start, end;
+        start = chrono::steady_clock::now();
+        evaluator.best_move_calculate();
+        end = chrono::steady_clock::now();
+        chrono::duration<double, milli> elapsed = end - start;
+
+        cout << setw(10) << (symmetry ? "on" : "off")
+             << setw(12) << evaluator.nb_simulations_get()
+             << setw(10) << static_cast<long>(elapsed.count());
+        if (symmetry) {
+            cout << "  speedup " << fixed << setprecision(2)
+                 << time_all / elapsed.count();
+        } else {
+            time_all = elapsed.count();
+        }
+        cout << endl;
+    }
+}
@@ -0,0 +1,115 @@
+/*----------------------------------------------------------------------------
+Benchmark: playouts of HexBoard, speed and heap allocations
+----------------------------------------------------------------------------*/
+
+// Module under benchmark
+#include "../hexboard.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+using namespace std;
+
+//******************************************************************************
+// Module variables
+//******************************************************************************
+static const Player player_X(player_e::X);
+
+// Number of calls to operator new since the start of the program.
+static unsigned long nb_allocations = 0;
+
+//******************************************************************************
+// Function prototypes
+//******************************************************************************
+void bench_playout(const unsigned size, const RandomEngine engine,
+                   const unsigned nb_playouts);
+
+// Count the allocations, the playouts are expected not to make any.
+void* operator new(size_t size)
+{
+    ++nb_allocations;
+    void* p = malloc(size);
+    if (p == nullptr) {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+// Usage: playout_bench [number of playouts per board size]
+int main(int argc, char *argv[])
+{
+    unsigned nb_playouts = 200000;
+    if (argc > 1) {
+        nb_playouts = atoi(argv[1]);
+    }
+
+    cout << setw(6) << "size" << setw(12) << "engine"
+         << setw(10) << "fill ns" << setw(12) << "playout ns"
+         << setw(14) << "playouts/s" << setw(14) << "allocations" << endl;
+    for (unsigned size: {7, 11, 16, 19, 33}) {
+        for (auto engine: {RandomEngine::MT19937, RandomEngine::PCG32,
+                           RandomEngine::XOSHIRO256}) {
+            bench_playout(size, engine, nb_playouts);
+        }
+    }
+    return 0;
+}
+
+// Run nb_playouts playouts on an empty board, the way the engines do: fill up
+// then restore the bitboard of the player. The fill up alone is timed first,
+// then the full playouts with the win check.
+void bench_playout(const unsigned size, const RandomEngine engine,
+                   const unsigned nb_playouts)
+{
+    static const char* engine_names[] = {"mt19937", "pcg32", "xoshiro256"};
+
+    HexBoard board(size);
+    board.random_engine_select(engine);
+    board.random_seed(1);
+    board.player_select(player_X);
+    board.occupied_save();
+
+    // Read a row, so that the fill up cannot be optimized away.
+    unsigned checksum = 0;
+    chrono::time_point<chrono::steady_clock> start, end;
+    start = chrono::steady_clock::now();
+    for (unsigned i = 0; i < nb_playouts; ++i) {
+        board.fill_up_half();
+        checksum += board.playout_rows_get()[0];
+        board.occupied_restore();
+    }
+    end = chrono::steady_clock::now();
+    chrono::duration<double, nano> fill_elapsed = end - start;
+
+    unsigned wins = 0;
+    unsigned long allocations_start = nb_allocations;
+    start = chrono::steady_clock::now();
+    for (unsigned i = 0; i < nb_playouts; ++i) {
+        if (board.fill_up_half_and_win_check()) {
+            ++wins;
+        }
+        board.occupied_restore();
+    }
+    end = chrono::steady_clock::now();
+    unsigned long allocations = nb_allocations - allocations_start;
+    chrono::duration<double, nano> elapsed = end - start;
+
+    // wins and checksum are printed so that the playouts cannot be optimized
+    // away.
+    cout << setw(6) << size
+         << setw(12) << engine_names[static_cast<int>(engine)]
+         << fixed << setprecision(1)
+         << setw(10) << fill_elapsed.count() / nb_playouts
+         << setw(12) << elapsed.count() / nb_playouts
+         << setw(14) << static_cast<long>(nb_playouts * 1e9 / elapsed.count())
+         << setw(14) << allocations
+         << "   (" << wins << " wins, " << checksum % 100 << ")" << endl;
+}
@@ -0,0 +1,166 @@
+/*----------------------------------------------------------------------------
+Benchmark: playout policies of HexBoard, with and without the inferior
+slots, cost and accuracy
+----------------------------------------------------------------------------*/
+
+// Module under benchmark
+#include "../hexboard.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+//******************************************************************************
+// Module variables
+//******************************************************************************
+static const Player player_X(player_e::X);
+
+// Half width of the 95% confidence interval of a win rate, and the normal
+// quantile that goes with it.
+static const double accuracy = 0.02;
+static const double z = 1.96;
+
+//******************************************************************************
+// Function prototypes
+//******************************************************************************
+vector<HexBoard> positions_make(const unsigned size,
+                                const unsigned nb_positions);
+void bench_policy(const unsigned size, const vector<HexBoard>& positions,
+                  const PlayoutPolicy policy, const bool inferior,
+                  const unsigned nb_playouts_per_move);
+
+// Usage: playout_policy_bench [number of playouts per move]
+int main(int argc, char *argv[])
+{
+    unsigned nb_playouts_per_move = 10000;
+    if (argc > 1) {
+        nb_playouts_per_move = atoi(argv[1]);
+    }
+
+    cout << "Per test move: playouts for a win rate within +/-" << accuracy
+         << " (95%), and to tell the best move from the second best (95%),"
+         << " medians over the positions." << endl;
+    cout << setw(6) << "size" << setw(10) << "policy" << setw(10) << "inferior"
+         << setw(12) << "playout ns" << setw(12) << "accuracy"
+         << setw(10) << "ms" << setw(12) << "separate"
+         << setw(10) << "ms" << endl;
+    for (unsigned size: {7, 11}) {
+        const vector<HexBoard> positions = positions_make(size, 10);
+        for (auto policy: {PlayoutPolicy::UNIFORM, PlayoutPolicy::BRIDGES}) {
+            for (bool inferior: {false, true}) {
+                bench_policy(size, positions, policy, inferior,
+                             nb_playouts_per_move);
+            }
+        }
+    }
+    return 0;
+}
+
+// Early game positions, X to move: size stones placed at random, half of
+// them by each player, with no winner.
+vector<HexBoard> positions_make(const unsigned size,
+                                const unsigned nb_positions)
+{
+    vector<HexBoard> positions;
+    for (unsigned i = 0; i < nb_positions; ++i) {
+        HexBoard board(size, i + 1);
+        Player player = player_X;
+        for (unsigned j = 0; j < 2 * (size / 2); ++j) {
+            const vector< pair<unsigned, unsigned> >& free_slots
+                = board.unoccupied_list_get();
+            board.place(free_slots[board.random_draw() % free_slots.size()],
+                        player);
+            player.swap();
+        }
+        positions.push_back(board);
+    }
+    return positions;
+}
+
+static double median(vector<double> values)
+{
+    sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+void bench_policy(const unsigned size, const vector<HexBoard>& positions,
+                  const PlayoutPolicy policy, const bool inferior,
+                  const unsigned nb_playouts_per_move)
+{
+    vector<double> nb_for_accuracy;
+    vector<double> nb_for_separation;
+    unsigned long nb_playouts = 0;
+    chrono::duration<double, nano> elapsed(0);
+
+    for (auto position: positions) {
+        position.playout_policy_select(policy);
+        position.inferior_slots_use(inferior);
+        const vector< pair<unsigned, unsigned> > tests
+            = position.unoccupied_list_get();
+
+        // Win rates of all the test moves, for X.
+        vector<double> rates;
+        for (auto test: tests) {
+            HexBoard board(position);
+            board.place(test, player_X);
+            board.player_select(player_X);
+            board.occupied_save();
+            unsigned wins = 0;
+            const chrono::steady_clock::time_point start
+                = chrono::steady_clock::now();
+            for (unsigned i = 0; i < nb_playouts_per_move; ++i) {
+                wins += board.fill_up_half_and_win_check();
+                board.occupied_restore();
+            }
+            elapsed += chrono::steady_clock::now() - start;
+            nb_playouts += nb_playouts_per_move;
+            rates.push_back(static_cast<double>(wins) / nb_playouts_per_move);
+        }
+
+        // The variance of a playout is p (1 - p): the more decisive the
+        // playouts, the fewer are needed.
+        vector<double> variances;
+        for (auto p: rates) {
+            variances.push_back(p * (1.0 - p));
+        }
+        nb_for_accuracy.push_back(z * z * median(variances)
+                                  / (accuracy * accuracy));
+
+        // Difference between the two best moves, against the variance of
+        // the difference of their estimates.
+        vector<unsigned> order(rates.size());
+        for (unsigned i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        partial_sort(order.begin(), order.begin() + 2, order.end(),
+                     [&](unsigned a, unsigned b) {
+                         return rates[a] > rates[b];
+                     });
+        const double gap = max(rates[order[0]] - rates[order[1]],
+                               1.0 / nb_playouts_per_move);
+        nb_for_separation.push_back(
+            z * z * (variances[order[0]] + variances[order[1]])
+            / (gap * gap));
+    }
+
+    const double playout_ns = elapsed.count() / nb_playouts;
+    const double accuracy_playouts = median(nb_for_accuracy);
+    const double separation_playouts = median(nb_for_separation);
+    cout << setw(6) << size
+         << setw(10) << (policy == PlayoutPolicy::BRIDGES ?
+                         "bridges" : "uniform")
+         << setw(10) << (inferior ? "yes" : "no")
+         << setw(12) << static_cast<long>(playout_ns)
+         << setw(12) << static_cast<long>(accuracy_playouts)
+         << setw(10) << fixed << setprecision(2)
+         << accuracy_playouts * playout_ns / 1e6
+         << setw(12) << static_cast<long>(separation_playouts)
+         << setw(10) << separation_playouts * playout_ns / 1e6
+         << endl;
+}
@@ -0,0 +1,162 @@
+/*----------------------------------------------------------------------------
+Benchmark: win detection of PlayoutBatch against HexBoard::win_check()
+----------------------------------------------------------------------------*/
+
+// Module under benchmark
+#include "../playoutbatch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "../hexboard.hpp"
+
+using namespace std;
+
+//******************************************************************************
+// Module variables
+//******************************************************************************
+static const Player player_X(player_e::X);
+
+//******************************************************************************
+// Function prototypes
+//******************************************************************************
+void bench_playoutbatch(const unsigned size, const unsigned nb_playouts);
+static double fill_time_ns(const unsigned size, const unsigned nb_playouts);
+static double scalar_time_ns(vector<HexBoard>& filled, const unsigned nb_rounds,
+                             unsigned& wins);
+static double batch_time_ns(vector<HexBoard>& filled, const unsigned nb_rounds,
+                            const PlayoutBatch::Kernel kernel, unsigned& wins);
+
+// Usage: playoutbatch_bench [number of playouts per board size]
+int main(int argc, char *argv[])
+{
+    unsigned nb_playouts = 200000;
+    if (argc > 1) {
+        nb_playouts = atoi(argv[1]);
+    }
+
+    cout << "best kernel: "
+         << PlayoutBatch::kernel_name(PlayoutBatch::kernel_best()) << endl;
+    cout << "ns per playout" << endl;
+    cout << setw(6) << "size" << setw(10) << "fill" << setw(10) << "scalar";
+    for (auto kernel: {PlayoutBatch::Kernel::SCALAR,
+                       PlayoutBatch::Kernel::SSE2,
+                       PlayoutBatch::Kernel::AVX2}) {
+        cout << setw(10) << PlayoutBatch::kernel_name(kernel);
+    }
+    cout << endl;
+    for (unsigned size: {7, 11, 16}) {
+        bench_playoutbatch(size, nb_playouts);
+    }
+    return 0;
+}
+
+// The fill up is timed alone. The win detection is timed on a set of boards
+// filled up beforehand, checked over and over: "scalar" is
+// HexBoard::win_check(), the others are the kernels of PlayoutBatch, up to the
+// best one of this CPU, including the copy of the boards into the batch. All
+// check the same boards, and must find the same number of wins.
+void bench_playoutbatch(const unsigned size, const unsigned nb_playouts)
+{
+    const unsigned nb_boards = 4096;
+    const unsigned nb_rounds = max(1u, nb_playouts / nb_boards);
+
+    vector<HexBoard> filled;
+    HexBoard board(size);
+    board.random_seed(1);
+    board.player_select(player_X);
+    for (unsigned i = 0; i < nb_boards; ++i) {
+        filled.push_back(board);
+        filled.back().random_seed(i);
+        filled.back().fill_up_half();
+    }
+
+    const double fill = fill_time_ns(size, nb_playouts);
+    unsigned scalar_wins;
+    const double scalar = scalar_time_ns(filled, nb_rounds, scalar_wins);
+
+    cout << setw(6) << size << fixed << setprecision(1)
+         << setw(10) << fill << setw(10) << scalar;
+    for (auto kernel: {PlayoutBatch::Kernel::SCALAR,
+                       PlayoutBatch::Kernel::SSE2,
+                       PlayoutBatch::Kernel::AVX2}) {
+        if (kernel > PlayoutBatch::kernel_best()) {
+            cout << setw(10) << "-";
+            continue;
+        }
+        unsigned wins;
+        cout << setw(10) << batch_time_ns(filled, nb_rounds, kernel, wins);
+        if (wins != scalar_wins) {
+            cout << " (wrong result)";
+        }
+    }
+    cout << endl;
+}
+
+static double fill_time_ns(const unsigned size, const unsigned nb_playouts)
+{
+    HexBoard board(size);
+    board.random_seed(1);
+    board.player_select(player_X);
+    board.occupied_save();
+
+    // Read the last row, so that the fill up cannot be optimized away.
+    unsigned checksum = 0;
+    chrono::time_point<chrono::steady_clock> start, end;
+    start = chrono::steady_clock::now();
+    for (unsigned i = 0; i < nb_playouts; ++i) {
+        board.fill_up_half();
+        checksum += board.playout_rows_get()[size - 1];
+        board.occupied_restore();
+    }
+    end = chrono::steady_clock::now();
+    chrono::duration<double, nano> elapsed = end - start;
+    if (checksum == 1) {
+        cout << " ";
+    }
+    return elapsed.count() / nb_playouts;
+}
+
+static double scalar_time_ns(vector<HexBoard>& filled, const unsigned nb_rounds,
+                             unsigned& wins)
+{
+    wins = 0;
+    chrono::time_point<chrono::steady_clock> start, end;
+    start = chrono::steady_clock::now();
+    for (unsigned round = 0; round < nb_rounds; ++round) {
+        for (auto& board: filled) {
+            if (board.win_check(player_X)) {
+                ++wins;
+            }
+        }
+    }
+    end = chrono::steady_clock::now();
+    chrono::duration<double, nano> elapsed = end - start;
+    return elapsed.count() / (nb_rounds * filled.size());
+}
+
+static double batch_time_ns(vector<HexBoard>& filled, const unsigned nb_rounds,
+                            const PlayoutBatch::Kernel kernel, unsigned& wins)
+{
+    PlayoutBatch playouts(filled[0].size_get());
+    playouts.kernel_set(kernel);
+
+    wins = 0;
+    chrono::time_point<chrono::steady_clock> start, end;
+    start = chrono::steady_clock::now();
+    for (unsigned round = 0; round < nb_rounds; ++round) {
+        for (auto& board: filled) {
+            playouts.board_add(board);
+            if (playouts.nb_boards_get() == PlayoutBatch::max_nb_boards) {
+                wins += __builtin_popcount(playouts.win_check());
+            }
+        }
+    }
+    end = chrono::steady_clock::now();
+    chrono::duration<double, nano> elapsed = end - start;
+    return elapsed.count() / (nb_rounds * filled.size());
+}
@@ -0,0 +1,321 @@
+/*----------------------------------------------------------------------------
+Benchmark suite: HexBoard operations and best_move_calculate(), on several
+board sizes and fill levels, with machine-readable output
+----------------------------------------------------------------------------*/
+
+// Modules under benchmark
+#include "../hexboard.hpp"
+#include "../moveeval.hpp"
+#include "../uctsearch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unistd.h> // getopt
+#include <vector>
+
+using namespace std;
+
+//******************************************************************************
+// Module variables
+//******************************************************************************
+static const Player player_X(player_e::X);
+
+// Seed of the positions and of the simulations, so that all runs measure the
+// same work.
+static const unsigned seed = 1;
+
+// Each benchmark runs for at least this long.
+static double min_seconds = 0.2;
+
+struct BenchResult {
+    string name;
+    unsigned size;
+    unsigned fill_percent;
+    unsigned long nb_operations;
+    double seconds;
+};
+
+static vector<BenchResult> results;
+
+//******************************************************************************
+// Function prototypes
+//******************************************************************************
+static void usage_print();
+static HexBoard position_make(const unsigned size, const unsigned fill_percent);
+static void result_add(const string& name, const unsigned size,
+                       const unsigned fill_percent,
+                       const unsigned long nb_operations, const double seconds);
+template <typename Operation>
+static void bench_repeat(const string& name, const unsigned size,
+                         const unsigned fill_percent, Operation operation);
+void bench_win_check(const HexBoard& position, const unsigned fill_percent);
+void bench_playout(const HexBoard& position, const unsigned fill_percent);
+void bench_save_restore(const HexBoard& position, const unsigned fill_percent);
+void bench_play_unplace(const HexBoard& position, const unsigned fill_percent);
+void bench_best_move_flat(const HexBoard& position,
+                          const unsigned fill_percent);
+void bench_best_move_uct(const HexBoard& position,
+                         const unsigned fill_percent);
+static void results_csv_print(ostream& os);
+static void results_json_print(ostream& os);
+
+// Usage: see usage_print().
+int main(int argc, char *argv[])
+{
+    string format = "csv";
+    string output_filename;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:o:t:")) != -1) {
+        switch (opt) {
+        case 'f':
+            format = optarg;
+            if ((format != "csv") && (format != "json")) {
+                usage_print();
+                return -1;
+            }
+            break;
+        case 'o':
+            output_filename = optarg;
+            break;
+        case 't':
+            min_seconds = atof(optarg) / 1000.0;
+            break;
+        default:
+            usage_print();
+            return -1;
+        }
+    }
+
+    for (unsigned size: {7, 11, 16, 19}) {
+        for (unsigned fill_percent: {0, 25, 50}) {
+            cerr << "size " << size << ", " << fill_percent << "% filled"
+                 << endl;
+            HexBoard position = position_make(size, fill_percent);
+            bench_win_check(position, fill_percent);
+            bench_playout(position, fill_percent);
+            bench_save_restore(position, fill_percent);
+            bench_play_unplace(position, fill_percent);
+            bench_best_move_flat(position, fill_percent);
+            bench_best_move_uct(position, fill_percent);
+        }
+    }
+
+    ofstream output_file;
+    if (!output_filename.empty()) {
+        output_file.open(output_filename);
+        if (!output_file) {
+            cerr << "Cannot open " << output_filename << endl;
+            return -1;
+        }
+    }
+    ostream& os = output_filename.empty() ? cout : output_file;
+    if (format == "json") {
+        results_json_print(os);
+    } else {
+        results_csv_print(os);
+    }
+    return 0;
+}
+
+static void usage_print()
+{
+    cerr << "Usage: suite_bench [-f csv|json] [-o file] [-t ms]" << endl;
+    cerr << "    -f: output format, csv (default) or json." << endl;
+    cerr << "    -o: output file, standard output by default." << endl;
+    cerr << "    -t: minimum duration of each benchmark, in milliseconds"
+         << " (default 200)." << endl;
+}
+
+// A position of a game in progress: fill_percent of the slots hold stones,
+// played alternately at random, without a winner yet.
+static HexBoard position_make(const unsigned size, const unsigned fill_percent)
+{
+    HexBoard board(size, seed);
+    mt19937 engine(seed);
+    Player player(player_e::X);
+    const unsigned nb_stones = size * size * fill_percent / 100;
+
+    for (unsigned i = 0; i < nb_stones; ++i) {
+        vector< pair<unsigned, unsigned> > free_slots
+            = board.unoccupied_list_get();
+        shuffle(free_slots.begin(), free_slots.end(), engine);
+        for (auto move: free_slots) {
+            if (!board.play(move, player)) {
+                break;
+            }
+            // That move wins, try another one.
+            board.unplace(move);
+        }
+        player.swap();
+    }
+    return board;
+}
+
+static void result_add(const string& name, const unsigned size,
+                       const unsigned fill_percent,
+                       const unsigned long nb_operations, const double seconds)
+{
+    results.push_back(BenchResult{name, size, fill_percent, nb_operations,
+                                  seconds});
+}
+
+// Run operation (which does nb_operations_per_call operations and returns that
+// number) until min_seconds have elapsed.
+template <typename Operation>
+static void bench_repeat(const string& name, const unsigned size,
+                         const unsigned fill_percent, Operation operation)
+{
+    unsigned long nb_operations = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    chrono::duration<double> elapsed;
+    do {
+        nb_operations += operation();
+        elapsed = chrono::steady_clock::now() - start;
+    } while (elapsed.count() < min_seconds);
+    result_add(name, size, fill_percent, nb_operations, elapsed.count());
+}
+
+// win_check() of X on boards filled up by a playout.
+void bench_win_check(const HexBoard& position, const unsigned fill_percent)
+{
+    vector<HexBoard> filled(64, position);
+    for (unsigned i = 0; i < filled.size(); ++i) {
+        filled[i].random_seed(i);
+        filled[i].player_select(player_X);
+        filled[i].fill_up_half();
+    }
+
+    unsigned wins = 0;
+    bench_repeat("win_check", position.size_get(), fill_percent, [&]() {
+        for (auto& board: filled) {
+            wins += board.win_check(player_X);
+        }
+        return filled.size();
+    });
+    if (wins == 1) {
+        cerr << " ";    // Keeps wins, and the win checks, alive.
+    }
+}
+
+// One playout the way the engines run it: fill up, check, restore.
+void bench_playout(const HexBoard& position, const unsigned fill_percent)
+{
+    HexBoard board(position);
+    board.random_seed(seed);
+    board.player_select(player_X);
+    board.occupied_save();
+
+    unsigned wins = 0;
+    bench_repeat("fill_up_half_and_win_check", position.size_get(),
+                 fill_percent, [&]() {
+        for (unsigned i = 0; i < 100; ++i) {
+            wins += board.fill_up_half_and_win_check();
+            board.occupied_restore();
+        }
+        return 100;
+    });
+    if (wins == 1) {
+        cerr << " ";
+    }
+}
+
+void bench_save_restore(const HexBoard& position, const unsigned fill_percent)
+{
+    HexBoard board(position);
+    board.player_select(player_X);
+
+    bench_repeat("occupied_save_restore", position.size_get(), fill_percent,
+                 [&]() {
+        for (unsigned i = 0; i < 1000; ++i) {
+            board.occupied_save();
+            board.occupied_restore();
+        }
+        return 1000;
+    });
+}
+
+// play() and unplace() of every free slot in turn.
+void bench_play_unplace(const HexBoard& position, const unsigned fill_percent)
+{
+    HexBoard board(position);
+    const vector< pair<unsigned, unsigned> > free_slots
+        = board.unoccupied_list_get();
+
+    unsigned wins = 0;
+    bench_repeat("play_unplace", position.size_get(), fill_percent, [&]() {
+        for (auto move: free_slots) {
+            wins += board.play(move, player_X);
+            board.unplace(move);
+        }
+        return free_slots.size();
+    });
+    if (wins == 1) {
+        cerr << " ";
+    }
+}
+
+// A full move of the flat Monte-Carlo engine, on one thread. The operations
+// are the playouts.
+void bench_best_move_flat(const HexBoard& position,
+                          const unsigned fill_percent)
+{
+    HexBoard board(position);
+    bench_repeat("best_move_calculate_flat", position.size_get(), fill_percent,
+                 [&]() {
+        MoveEvaluator evaluator(board, player_X, UINT_MAX, 200, 1, seed);
+        evaluator.best_move_calculate();
+        return evaluator.nb_simulations_get();
+    });
+}
+
+// Same budget for the UCT engine, with a new tree for each move.
+void bench_best_move_uct(const HexBoard& position,
+                         const unsigned fill_percent)
+{
+    HexBoard board(position);
+    board.random_seed(seed);
+    bench_repeat("best_move_calculate_uct", position.size_get(), fill_percent,
+                 [&]() {
+        UctSearch search(board, player_X, UINT_MAX, 200);
+        search.best_move_calculate();
+        return search.nb_simulations_get();
+    });
+}
+
+static void results_csv_print(ostream& os)
+{
+    os << "benchmark,size,fill_percent,operations,seconds,ns_per_operation,"
+       << "operations_per_second" << endl;
+    for (auto& result: results) {
+        os << result.name << "," << result.size << "," << result.fill_percent
+           << "," << result.nb_operations << "," << result.seconds << ","
+           << result.seconds * 1e9 / result.nb_operations << ","
+           << result.nb_operations / result.seconds << endl;
+    }
+}
+
+static void results_json_print(ostream& os)
+{
+    os << "{\"results\": [" << endl;
+    for (unsigned i = 0; i < results.size(); ++i) {
+        const BenchResult& result = results[i];
+        os << "  {\"benchmark\": \"" << result.name << "\", "
+           << "\"size\": " << result.size << ", "
+           << "\"fill_percent\": " << result.fill_percent << ", "
+           << "\"operations\": " << result.nb_operations << ", "
+           << "\"seconds\": " << result.seconds << ", "
+           << "\"ns_per_operation\": "
+           << result.seconds * 1e9 / result.nb_operations << ", "
+           << "\"operations_per_second\": "
+           << result.nb_operations / result.seconds << "}"
+           << ((i + 1 < results.size()) ? "," : "") << endl;
+    }
+    os << "]}" << endl;
+}
@@ -0,0 +1,151 @@
+/*----------------------------------------------------------------------------
+Benchmark: scaling of the parallel modes of UctSearch, shared tree against
+root parallel, at equal time per move
+----------------------------------------------------------------------------*/
+
+// Module under benchmark
+#include "../uctsearch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../hexboard.hpp"
+
+using namespace std;
+
+//******************************************************************************
+// Module variables
+//******************************************************************************
+static const Player player_X(player_e::X);
+
+// Time of the reference search of each position, in times the time per move.
+static const unsigned reference_factor = 20;
+
+//******************************************************************************
+// Function prototypes
+//******************************************************************************
+vector<HexBoard> positions_make(const unsigned size,
+                                const unsigned nb_positions);
+pair<unsigned, unsigned> search_run(HexBoard position, const unsigned ms,
+                                    const unsigned nb_threads,
+                                    const UctParallel mode,
+                                    unsigned long& nb_simulations);
+void bench_parallel(const vector<HexBoard>& positions,
+                    const vector< pair<unsigned, unsigned> >& references,
+                    const unsigned ms, const unsigned nb_threads,
+                    const UctParallel mode, double& serial_rate);
+
+// Usage: uct_parallel_bench [max number of threads] [ms per move]
+int main(int argc, char *argv[])
+{
+    unsigned max_nb_threads = max(thread::hardware_concurrency(), 1u);
+    unsigned ms = 200;
+    if (argc > 1) {
+        max_nb_threads = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        ms = atoi(argv[2]);
+    }
+
+    const unsigned size = 11;
+    const vector<HexBoard> positions = positions_make(size, 8);
+
+    // The move of a long single threaded search of each position. The better
+    // a parallel search uses its threads, the more often it finds the same
+    // move in less time.
+    vector< pair<unsigned, unsigned> > references;
+    for (const auto& position: positions) {
+        unsigned long nb_simulations;
+        references.push_back(search_run(position, reference_factor * ms, 1,
+                                        UctParallel::TREE, nb_simulations));
+    }
+
+    cout << size << "x" << size << ", " << ms << " ms per move, "
+         << positions.size() << " positions. Same move as a single thread in "
+         << reference_factor << " times the time." << endl;
+    cout << setw(8) << "threads" << setw(8) << "mode"
+         << setw(14) << "simulations/s" << setw(10) << "speedup"
+         << setw(12) << "same move" << endl;
+    double serial_rate = 0.0;
+    bench_parallel(positions, references, ms, 1, UctParallel::TREE,
+                   serial_rate);
+    for (unsigned n = 2; n <= max_nb_threads; n *= 2) {
+        for (auto mode: {UctParallel::TREE, UctParallel::ROOT}) {
+            bench_parallel(positions, references, ms, n, mode, serial_rate);
+        }
+    }
+    return 0;
+}
+
+// Early game positions, X to move: size stones placed at random, half of
+// them by each player.
+vector<HexBoard> positions_make(const unsigned size,
+                                const unsigned nb_positions)
+{
+    vector<HexBoard> positions;
+    for (unsigned i = 0; i < nb_positions; ++i) {
+        HexBoard board(size, i + 1);
+        Player player = player_X;
+        for (unsigned j = 0; j < 2 * (size / 2); ++j) {
+            const vector< pair<unsigned, unsigned> >& free_slots
+                = board.unoccupied_list_get();
+            board.place(free_slots[board.random_draw() % free_slots.size()],
+                        player);
+            player.swap();
+        }
+        positions.push_back(board);
+    }
+    return positions;
+}
+
+// A new search of position for ms milliseconds.
+pair<unsigned, unsigned> search_run(HexBoard position, const unsigned ms,
+                                    const unsigned nb_threads,
+                                    const UctParallel mode,
+                                    unsigned long& nb_simulations)
+{
+    UctSearch search(position, player_X, UINT_MAX, UINT_MAX);
+    search.threads_set(nb_threads);
+    search.parallel_set(mode);
+    search.deadline_set(chrono::steady_clock::now()
+                        + chrono::milliseconds(ms));
+    const pair<unsigned, unsigned> move = search.best_move_calculate();
+    nb_simulations = search.nb_simulations_get();
+    return move;
+}
+
+// serial_rate is set by the single threaded run, the speedups are relative
+// to it.
+void bench_parallel(const vector<HexBoard>& positions,
+                    const vector< pair<unsigned, unsigned> >& references,
+                    const unsigned ms, const unsigned nb_threads,
+                    const UctParallel mode, double& serial_rate)
+{
+    unsigned long nb_simulations = 0;
+    unsigned nb_same = 0;
+    for (unsigned i = 0; i < positions.size(); ++i) {
+        unsigned long nb;
+        nb_same += (search_run(positions[i], ms, nb_threads, mode, nb)
+                    == references[i]);
+        nb_simulations += nb;
+    }
+
+    const double rate = nb_simulations * 1000.0 / (ms * positions.size());
+    if (nb_threads == 1) {
+        serial_rate = rate;
+    }
+    const char* name = (nb_threads == 1) ? "serial"
+        : (mode == UctParallel::TREE) ? "tree" : "root";
+    cout << setw(8) << nb_threads << setw(8) << name
+         << setw(14) << static_cast<long>(rate)
+         << setw(10) << fixed << setprecision(2) << rate / serial_rate
+         << setw(11) << setprecision(0)
+         << 100.0 * nb_same / positions.size() << "%" << endl;
+}
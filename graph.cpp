@@ -6,6 +6,7 @@ Graph class implementation
 #include <iostream>
 #include <iomanip>  // For width of display
 #include <cstdlib>
+#include <random>
 #include <vector>
 
 #include "graph.hpp"
@@ -18,16 +19,18 @@ const cost_t COST_MAX = numeric_limits<cost_t>::max();
 /// \brief  Pick a number of elements of a vector randomly.
 /// \param  input   The vector that contains data to pick from.
 /// \param  nb_out  The number of elements to randomly pick.
+/// \param  engine  Random engine, e.g. mt19937, seeded by the caller so that
+///                 the pick can be reproduced.
 /// \return A new vector containing nb_out elements, chosen randomly form input.
 //  ----------------------------------------------------------------------------
-template <class T>
-vector<T> random_pick(vector<T> input, const int nb_out)
+template <class T, class Engine>
+vector<T> random_pick(vector<T> input, const int nb_out, Engine& engine)
 {
     vector<T> out;
     out.reserve(nb_out);
 
     for (int i = 0; i < nb_out; ++i) {
-        int index = rand() % input.size();
+        int index = uniform_int_distribution<int>(0, input.size() - 1)(engine);
         // Put the newly picked element in the output vector.
         out.push_back(input[index]);
         // Remove the newly picked element to avoid picking it twice.
@@ -5,41 +5,163 @@
   Kharlamov, https://github.com/alexkh/hexai/blob/master/dummy.cpp
   Big chunks of the code below are taken from the repository above.
 - interactively, AI vs AI, Human vs Human, AI vs Human.
+- as an analysis server, answering positions with the best move.
   ------------------------------------------------------------------------------*/
+#include <algorithm>
 #include <chrono>
 #include <climits>
 #include <cstdlib>  // atoi, rand
 #include <ctime>
 #include <iostream>
 #include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h> // getopt
 #include <utility>  // pair
 
+#include "analysis.hpp"
 #include "hexgame.hpp"
 #include "moveeval.hpp"
+#include "trace.hpp"
 
 using namespace std;
 
-static const unsigned max_size = 16u;
+// Interactive and automatic play name the columns with a single letter. The
+// larger boards, up to hexboard_max_size, are for the analysis server and
+// hexmatch.
+static const unsigned max_size = 26;
+
+// Settings of the AI, from the command line options.
+struct AiOptions {
+    unsigned nb_threads;
+    EngineType engine;
+    UctParallel uct_parallel;
+    // Option -u given, else the mode follows from the seed.
+    bool uct_parallel_given;
+    bool amaf;
+    PlayoutPolicy playout_policy;
+    bool inferior_slots;
+    bool ponder;
+    unsigned time_budget_ms;
+    bool time_budget_per_game;
+    bool seeded;
+    unsigned long seed;
+    unsigned transposition_megabytes;
+    // Empty for no opening book.
+    string book_filename;
+};
+
+// Return false if the options cannot be applied.
+static bool ai_options_apply(HexGame& game, const AiOptions& options)
+{
+    game.threads_set(options.nb_threads);
+    game.engine_set(options.engine);
+    game.uct_parallel_set(options.uct_parallel);
+    game.amaf_set(options.amaf);
+    game.playout_policy_set(options.playout_policy);
+    game.inferior_slots_use(options.inferior_slots);
+    game.ponder_set(options.ponder);
+    game.time_budget_set(options.time_budget_ms, options.time_budget_per_game);
+    game.transposition_table_size_set(options.transposition_megabytes);
+    if (options.seeded) {
+        game.random_seed(options.seed);
+    }
+    if (!options.book_filename.empty()
+        && !game.opening_book_open(options.book_filename)) {
+        cerr << "E: cannot open opening book " << options.book_filename
+             << endl;
+        return false;
+    }
+    return true;
+}
+
+// The settings of the AI that apply to the analysis of positions.
+static void analysis_options_apply(AnalysisServer& server,
+                                   const AiOptions& options)
+{
+    server.threads_set(options.nb_threads);
+    server.engine_set(options.engine);
+    server.uct_parallel_set(options.uct_parallel);
+    server.amaf_set(options.amaf);
+    server.playout_policy_set(options.playout_policy);
+    server.inferior_slots_use(options.inferior_slots);
+    server.transposition_table_size_set(options.transposition_megabytes);
+    if (options.seeded) {
+        server.random_seed(options.seed);
+    }
+}
 
 static void usage_print()
 {
     cout << "Usage:" << endl;
-    cout << "hexjakt size" << endl;
+    cout << "hexjakt [options] size" << endl;
     cout << "- interactive play" << endl;
-    cout << "    size: size of the board side, less than " << max_size << endl;
+    cout << "    size: size of the board side, at most " << max_size << endl;
     cout << endl;
-    cout << "hexjakt P [size] [iter]" << endl;
+    cout << "hexjakt [options] P [size] [iter]" << endl;
     cout << "- automatic play" << endl;
     cout << "    P: the player color (X or O). X plays first, north/south."
          << endl;
-    cout << "    size: size of the board side, less than " << max_size << endl;
+    cout << "    size: size of the board side, at most " << max_size << endl;
     cout << "    iter: max number of Monte-Carlo iterations per test move."
          << endl;
+    cout << endl;
+    cout << "hexjakt [options] serve [socket]" << endl;
+    cout << "- analysis server: answer the positions of the requests, one per"
+         << " line, with the best move and its win rate, until \"quit\""
+         << endl;
+    cout << "    socket: path of a Unix domain socket to listen on, instead of"
+         << " the standard input and output. An existing file there must be a"
+         << " socket." << endl;
+    cout << "    request: size player budget [stones], e.g."
+         << " \"11 X 200ms Xf6 Oe7\", the budget in iterations per test move"
+         << " or in milliseconds (ms)." << endl;
+    cout << "    answer: \"= move win_rate\", e.g. \"= e6 0.583\", or"
+         << " \"? error\"." << endl;
+    cout << endl;
+    cout << "options:" << endl;
+    cout << "    -t threads: number of threads for the AI, 0 for one per core"
+         << " (default 1)." << endl;
+    cout << "    -e engine: search engine of the AI, flat (flat Monte-Carlo,"
+         << " default), halving (flat Monte-Carlo by successive halving) or"
+         << " uct (tree search)." << endl;
+    cout << "    -u mode: with several threads, the uct engine searches one"
+         << " tree shared by all the threads (tree, default), or one tree per"
+         << " thread, merged at the root (root, default with -s). The"
+         << " shared tree depends on the timing of the threads, and does not"
+         << " play the same moves again." << endl;
+    cout << "    -a: blend all-moves-as-first (AMAF) statistics of the"
+         << " playouts into the scores of the flat engines." << endl;
+    cout << "    -p policy: playout policy, uniform (default) or bridges"
+         << " (the bridges on the board stay connected)." << endl;
+    cout << "    -i: leave the dead and captured slots out of the moves"
+         << " searched, and fill them up first in the playouts." << endl;
+    cout << "    -P: in automatic play, go on searching while the opponent"
+         << " thinks (pondering). Only with the uct engine, or with a"
+         << " transposition table (-H) for the flat engines." << endl;
+    cout << "    -m ms: think ms milliseconds per move, instead of a number of"
+         << " iterations." << endl;
+    cout << "    -g ms: think ms milliseconds for all the moves of the game."
+         << endl;
+    cout << "    -s seed: seed of the AI, the same seed and iterations play"
+         << " the same moves, whatever the threads with the flat engines, for"
+         << " a given number of threads with uct (default: seeded from the"
+         << " time). Not with -u tree." << endl;
+    cout << "    -H mb: share the statistics of the positions in a"
+         << " transposition table of mb megabytes (default 0, none)." << endl;
+    cout << "    -b file: play the moves of the opening book file (see"
+         << " hexbook) while the position is in it." << endl;
+    cout << "    -T file: write the search counters of each move of automatic"
+         << " play to file instead of the standard error (builds with"
+         << " TRACE=1 only)." << endl;
 }
 
-static void interactive_game(const unsigned size)
+static void interactive_game(const unsigned size, const AiOptions& options)
 {
     HexGame game(size);
+    if (!ai_options_apply(game, options)) {
+        exit(-1);
+    }
     cout << size <<endl;
     game.start_prompt();
     game.player_setup_prompt_and_set();
@@ -53,10 +175,26 @@ static void interactive_game(const unsigned size)
     game.winner_print();
 }
 
+static int analysis_serve(const char* socket_path, const AiOptions& options)
+{
+    AnalysisServer server;
+    analysis_options_apply(server, options);
+    if (socket_path == nullptr) {
+        server.serve(0, 1);
+    } else if (!server.socket_serve(socket_path)) {
+        cerr << "E: cannot listen on " << socket_path << endl;
+        return -3;
+    }
+    return 0;
+}
+
 static void automatic_game(const unsigned size, const char color,
-                           const unsigned iter)
+                           const unsigned iter, const AiOptions& options)
 {
     HexGame game(size, iter);
+    if (!ai_options_apply(game, options)) {
+        exit(-1);
+    }
 
     int result = game.autoplay_handshake(color);
     if (result < 0) {
@@ -79,6 +217,135 @@ int main(int argc, char *argv[])
     char color = 'X'; // can be X or O
     unsigned short board_side = 11; // side of the board minimum 3
     size_t iter = 1000; // number of iterations should be selectable
+    AiOptions options = {
+        1,                      // nb_threads
+        EngineType::FLAT_MC,    // engine
+        UctParallel::TREE,      // uct_parallel
+        false,                  // uct_parallel_given
+        false,                  // amaf
+        PlayoutPolicy::UNIFORM, // playout_policy
+        false,                  // inferior_slots
+        false,                  // ponder
+        0,                      // time_budget_ms
+        false,                  // time_budget_per_game
+        false,                  // seeded
+        0,                      // seed
+        0,                      // transposition_megabytes
+        ""                      // book_filename
+    };
+
+    // Options first, the positional parameters are left in argv[optind...].
+    int opt;
+    while ((opt = getopt(argc, argv, "t:e:u:ap:iPm:g:s:H:b:T:")) != -1) {
+        switch (opt) {
+        case 't':
+        {
+            stringstream ss;
+            ss << optarg;
+            ss >> options.nb_threads;
+            if (options.nb_threads == 0) {
+                options.nb_threads = max(thread::hardware_concurrency(), 1u);
+            }
+        }
+        break;
+        case 'e':
+            if (string(optarg) == "uct") {
+                options.engine = EngineType::UCT;
+            } else if (string(optarg) == "flat") {
+                options.engine = EngineType::FLAT_MC;
+            } else if (string(optarg) == "halving") {
+                options.engine = EngineType::FLAT_MC_HALVING;
+            } else {
+                usage_print();
+                return -1;
+            }
+            break;
+        case 'u':
+            if (string(optarg) == "tree") {
+                options.uct_parallel = UctParallel::TREE;
+            } else if (string(optarg) == "root") {
+                options.uct_parallel = UctParallel::ROOT;
+            } else {
+                usage_print();
+                return -1;
+            }
+            options.uct_parallel_given = true;
+            break;
+        case 'a':
+            options.amaf = true;
+            break;
+        case 'p':
+            if (string(optarg) == "uniform") {
+                options.playout_policy = PlayoutPolicy::UNIFORM;
+            } else if (string(optarg) == "bridges") {
+                options.playout_policy = PlayoutPolicy::BRIDGES;
+            } else {
+                usage_print();
+                return -1;
+            }
+            break;
+        case 'i':
+            options.inferior_slots = true;
+            break;
+        case 'P':
+            options.ponder = true;
+            break;
+        case 'm':
+        case 'g':
+        {
+            stringstream ss;
+            ss << optarg;
+            ss >> options.time_budget_ms;
+            options.time_budget_per_game = (opt == 'g');
+        }
+        break;
+        case 's':
+        {
+            stringstream ss;
+            ss << optarg;
+            ss >> options.seed;
+            options.seeded = true;
+        }
+        break;
+        case 'H':
+        {
+            stringstream ss;
+            ss << optarg;
+            ss >> options.transposition_megabytes;
+        }
+        break;
+        case 'b':
+            options.book_filename = optarg;
+            break;
+        case 'T':
+            if (!trace_output_open(optarg)) {
+                cerr << "Cannot open trace file " << optarg
+                     << ", or tracing not compiled in (make TRACE=1)." << endl;
+                return -1;
+            }
+            break;
+        default:
+            usage_print();
+            return -1;
+        }
+    }
+    // Only the separate trees of the threads are reproducible.
+    if (options.seeded) {
+        if (options.uct_parallel_given
+            && (options.uct_parallel == UctParallel::TREE)) {
+            cerr << "E: -s plays the same moves with -u root only" << endl;
+            return -1;
+        }
+        options.uct_parallel = UctParallel::ROOT;
+    }
+    // Make the positional parameters start at argv[1], as if there had been no
+    // options.
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if ((argc > 1) && (string(argv[1]) == "serve")) {
+        return analysis_serve((argc > 2) ? argv[2] : nullptr, options);
+    }
 
     // parse command line parameters
     argc = argc > 4? 4: argc; // forward compatibility measure
@@ -104,11 +371,11 @@ int main(int argc, char *argv[])
     {
         color = argv[1][0];
         if (color == 'X' || color == 'O') {
-            automatic_game(board_side, color, iter);
+            automatic_game(board_side, color, iter, options);
         } else if (static_cast<unsigned>(atoi(argv[1])) <= max_size) {
             // More input checking would be nice.
             board_side = static_cast<unsigned>(atoi(argv[1]));
-            interactive_game(board_side);
+            interactive_game(board_side, options);
         } else {
             usage_print();
             return -1; // there is some error
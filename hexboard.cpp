@@ -11,33 +11,73 @@ Implementation of a hex board
 #include "hexboard.hpp"
 #include "graph.hpp"
 #include "player.hpp"
+#include "trace.hpp"
 
 using namespace std;
 
 const int nb_players = 2;
 
-static inline void comb_step_down(vector<uint16_t>& combed,
-                                  vector<uint16_t> const& occupied,
+template <typename row_t>
+static inline void comb_step_down(row_t* combed,
+                                  const row_t* occupied,
                                   const unsigned i);
 
-static inline bool comb_step_up(vector<uint16_t>& combed,
-                                vector<uint16_t> const& occupied,
+template <typename row_t>
+static inline bool comb_step_up(row_t* combed,
+                                const row_t* occupied,
                                 const unsigned i);
 
-static inline bool comb_laterally_spread(vector<uint16_t>& combed,
-                                         vector<uint16_t> const& occupied,
+template <typename row_t>
+static inline bool comb_laterally_spread(row_t* combed,
+                                         const row_t* occupied,
                                          const unsigned i);
 
 
+// Seed only once, at object creation. This could lead to troubles if several
+// boards were to be created within a second. Not a problem now.
+HexBoard::HexBoard(unsigned size): HexBoard(size, time(0))
+{
+}
+
+// Drawn once, from a fixed seed.
+const ZobristKeys& zobrist_keys_get()
+{
+    static const ZobristKeys keys = []() {
+        ZobristKeys k;
+        Xoshiro256 engine(0x5eed2b1fULL);
+        for (auto& player_keys: k.stones) {
+            for (auto& key: player_keys) {
+                key = engine();
+            }
+        }
+        for (auto& key: k.sizes) {
+            key = engine();
+        }
+        k.O_to_move = engine();
+        return k;
+    }();
+    return keys;
+}
+
 // 4 extra virtual nodes for the board, representing the edges. These were added
 // to ease checking for winning condition.
-HexBoard::HexBoard(unsigned size): size(size),
-                                   west(size * size), east(size * size + 1),
-                                   north(size * size + 2), south(size * size +3)
+HexBoard::HexBoard(unsigned size, const mt19937::result_type seed):
+    size(size),
+    west(size * size), east(size * size + 1),
+    north(size * size + 2), south(size * size +3),
+    zobrist(&zobrist_keys_get()),
+    hash(zobrist->sizes[size]),
+    hash_rotated(hash),
+    groups_tracked(false),
+    playout_policy(PlayoutPolicy::UNIFORM),
+    bridges_valid(false),
+    inferior_used(false),
+    inferior_slots(size * size, InferiorSlot::NONE),
+    inferior_valid(false),
+    inferior_rings(size * size, 0),
+    random_engine(RandomEngine::PCG32)
 {
-    // Seed only once, at object creation. This could lead to troubles if
-    // several boards were to be created within a second. Not a problem now.
-    random_engine.seed(time(0));
+    random_seed(seed);
 
     // 4 extra virtual nodes for the board, representing the rims. These were
     // added to ease checking for winning condition.
@@ -98,13 +138,24 @@ HexBoard::HexBoard(unsigned size): size(size),
 
     // All slots are unoccupied to start with.
     unoccupied_list.reserve(size * size);
+    unoccupied_index.resize(size * size);
     for (unsigned row = 0; row < size; ++row) {
         for (unsigned col = 0; col < size; ++col) {
+            unoccupied_index[coord2lin(col, row)] = unoccupied_list.size();
             unoccupied_list.push_back(make_pair(col, row));
         }
     }
-    occupied_O.resize(size);
-    occupied_X.resize(size);
+
+    if (size <= 16) {
+        row_bits = 16;
+    } else if (size <= 32) {
+        row_bits = 32;
+    } else {
+        row_bits = 64;
+    }
+    bitboards_16 = HexBitboards<uint16_t>();
+    bitboards_32 = HexBitboards<uint32_t>();
+    bitboards_64 = HexBitboards<uint64_t>();
 }
 
 bool HexBoard::sanity_check()
@@ -131,18 +182,45 @@ bool HexBoard::play(unsigned col, unsigned row, Player player)
         return false;
     }
     place(col, row, player);
+    if (groups_tracked) {
+        return groups.win_check(player);
+    }
     return win_check(player);
 }
 
 void HexBoard::place(const unsigned col, const unsigned row, const Player player)
 {
     occupied_set(col, row, player);
+    if (groups_tracked) {
+        groups.stone_add(col, row, player);
+    }
 }
 
 void HexBoard::unplace(const unsigned col, const unsigned row)
 {
     Player old_player = occupied_map[row][col];
     occupied_reset(col, row, old_player);
+    if (groups_tracked) {
+        groups.stone_remove(col, row);
+    }
+}
+
+void HexBoard::groups_track(const bool enable)
+{
+    groups_tracked = enable;
+    if (!enable) {
+        groups = HexGroups();
+        return;
+    }
+
+    groups = HexGroups(size);
+    for (unsigned row = 0; row < size; ++row) {
+        for (unsigned col = 0; col < size; ++col) {
+            if (occupied_map[row][col].is_player()) {
+                groups.stone_add(col, row, occupied_map[row][col]);
+            }
+        }
+    }
 }
 
 //  ----------------------------------------------------------------------------
@@ -151,25 +229,38 @@ void HexBoard::unplace(const unsigned col, const unsigned row)
 //  ----------------------------------------------------------------------------
 void HexBoard::fill_up(Player player)
 {
-    vector< pair<unsigned, unsigned> >& free_pos = unoccupied_list_get();
-
-    // Order the future moves randomly.
-    shuffle(free_pos.begin(), free_pos.end(), random_engine);
+    vector< pair<unsigned, unsigned> >& free_pos = unoccupied_list;
 
     // If the number of free position is not even, first_player is the one to
     // play once more than the other. This is solved with integer division,
     // (which truncates downwards if not even) and starting with the other
     // player.
+    // The stones of the other player are picked randomly, with a partial
+    // Fisher-Yates shuffle. The rest goes to first_player.
     player.swap();
     unsigned i;
     for (i = 0; i < free_pos.size() / 2; ++i) {
+        unoccupied_swap(i, i + random_below(free_pos.size() - i));
         occupied_map[free_pos[i].second][free_pos[i].first] = player;
+        hash ^= stone_key_get(free_pos[i].first, free_pos[i].second, player);
+        hash_rotated ^= stone_key_get(size - 1 - free_pos[i].first,
+                                      size - 1 - free_pos[i].second, player);
     }
     player.swap();
     for (; i < free_pos.size(); ++i) {
         occupied_map[free_pos[i].second][free_pos[i].first] = player;
+        hash ^= stone_key_get(free_pos[i].first, free_pos[i].second, player);
+        hash_rotated ^= stone_key_get(size - 1 - free_pos[i].first,
+                                      size - 1 - free_pos[i].second, player);
     }
     unoccupied_list.clear();
+    bridges_valid = false;
+    inferior_valid = false;
+
+    // occupied_map was filled directly, start the groups over from it.
+    if (groups_tracked) {
+        groups_track(true);
+    }
 }
 
 //  ----------------------------------------------------------------------------
@@ -182,35 +273,590 @@ void HexBoard::fill_up(Player player)
 //  ----------------------------------------------------------------------------
 bool HexBoard::fill_up_half_and_win_check()
 {
-    vector< pair<unsigned, unsigned> >& free_pos = unoccupied_list_get();
-    // Order the future moves randomly. This does not modify the content of the
-    // class, only the order of the content.
-    shuffle(free_pos.begin(), free_pos.end(), random_engine);
+    switch (row_bits) {
+    case 16:
+        return fill_up_half_and_win_check_rows<uint16_t>();
+    case 32:
+        return fill_up_half_and_win_check_rows<uint32_t>();
+    default:
+        return fill_up_half_and_win_check_rows<uint64_t>();
+    }
+}
+
+template <typename row_t>
+bool HexBoard::fill_up_half_and_win_check_rows()
+{
+    fill_up_half_rows<row_t>();
+    return win_check_rows<row_t>(current_player);
+}
+
+void HexBoard::fill_up_half()
+{
+    switch (row_bits) {
+    case 16:
+        fill_up_half_rows<uint16_t>();
+        break;
+    case 32:
+        fill_up_half_rows<uint32_t>();
+        break;
+    default:
+        fill_up_half_rows<uint64_t>();
+        break;
+    }
+}
+
+template <typename row_t>
+void HexBoard::fill_up_half_rows()
+{
+    TRACE_COUNT(playouts, 1);
+    TRACE_TIME(fill_ns);
+    switch (random_engine) {
+    case RandomEngine::MT19937:
+        fill_up_half_rows<row_t>(random_mt19937);
+        break;
+    case RandomEngine::PCG32:
+        fill_up_half_rows<row_t>(random_pcg32);
+        break;
+    default:
+        fill_up_half_rows<row_t>(random_xoshiro256);
+        break;
+    }
+}
 
+template <typename row_t, typename Engine>
+void HexBoard::fill_up_half_rows(Engine& engine)
+{
     // If the number of free positions is not even, player is the one to
     // play once less than the other, since it has already played its test move.
     // Solved with integer division (rounding downwards).
-    for (unsigned i = 0; i < free_pos.size() / 2; ++i) {
-        (this->*occupied_player_set)(free_pos[i].first, free_pos[i].second);
+    const unsigned nb_free = unoccupied_list.size();
+    const unsigned nb_stones = nb_free / 2;
+
+    // The bits go straight into the rows of the player. O rows are the
+    // columns of the board.
+    HexBitboards<row_t>& bitboards = bitboards_get<row_t>();
+    const bool transposed = (current_player.get() == player_e::O);
+    row_t* rows = transposed
+        ? bitboards.occupied_O.data()
+        : bitboards.occupied_X.data();
+
+    // The slots drawn go to the front of the list, from first. Those that
+    // must go to the other player go to the back, before end.
+    unsigned first = 0;
+    unsigned end = nb_free;
+    if (inferior_used) {
+        if (!inferior_valid) {
+            inferior_find();
+        }
+        // The stone of a dead slot does not matter, it goes where there is
+        // room. So do the captured slots, in the rare case where the owner
+        // has fewer stones to place than captured slots.
+        const vector<unsigned>& own = captured_slots[transposed];
+        const vector<unsigned>& other = captured_slots[!transposed];
+        for (auto slot: own) {
+            unoccupied_swap((first < nb_stones) ? first++ : --end,
+                            unoccupied_index[slot]);
+        }
+        for (auto slot: other) {
+            unoccupied_swap((end > nb_stones) ? --end : first++,
+                            unoccupied_index[slot]);
+        }
+        for (auto slot: dead_slots) {
+            unoccupied_swap((end > nb_stones) ? --end : first++,
+                            unoccupied_index[slot]);
+        }
+    }
+    if (playout_policy == PlayoutPolicy::BRIDGES) {
+        if (!bridges_valid) {
+            bridges_find();
+        }
+        // One random bit per carrier.
+        uint32_t bits = 0;
+        for (unsigned i = 0; i < bridge_carriers.size(); ++i) {
+            if (i % 32 == 0) {
+                bits = ::random_below(engine, UINT32_MAX);
+            }
+            unsigned own = bridge_carriers[i].first;
+            unsigned other = bridge_carriers[i].second;
+            if (bits & 1) {
+                swap(own, other);
+            }
+            bits >>= 1;
+            // Without the inferior slots, the carriers always fit.
+            if ((first >= nb_stones) || (end <= nb_stones)
+                || (inferior_used
+                    && ((inferior_slots[own] != InferiorSlot::NONE)
+                        || (inferior_slots[other] != InferiorSlot::NONE)))) {
+                continue;
+            }
+            unoccupied_swap(first++, unoccupied_index[own]);
+            unoccupied_swap(--end, unoccupied_index[other]);
+        }
+    }
+
+    // Partial Fisher-Yates shuffle: only the slots that get a stone are drawn.
+    // This does not modify the content of the list, only its order.
+    for (unsigned i = first; i < nb_stones; ++i) {
+        unoccupied_swap(i, i + ::random_below(engine, end - i));
+    }
+    for (unsigned i = 0; i < nb_stones; ++i) {
+        const unsigned col = unoccupied_list[i].first;
+        const unsigned row = unoccupied_list[i].second;
+        if (transposed) {
+            rows[col] |= row_t(1) << row;
+        } else {
+            rows[row] |= row_t(1) << col;
+        }
+    }
+}
+
+void HexBoard::bridges_find()
+{
+    switch (row_bits) {
+    case 16:
+        bridges_find_rows<uint16_t>();
+        break;
+    case 32:
+        bridges_find_rows<uint32_t>();
+        break;
+    default:
+        bridges_find_rows<uint64_t>();
+        break;
+    }
+    bridges_valid = true;
+}
+
+template <typename row_t>
+void HexBoard::bridges_find_rows()
+{
+    HexBitboards<row_t>& bitboards = bitboards_get<row_t>();
+    // The free slots, in the layout of X, and transposed as for O. The
+    // combed rows are free until the next win check.
+    typename HexBitboards<row_t>::rows_t empty_O;
+    row_t* empty_X = bitboards.combed.data();
+    fill_n(empty_X, size, 0);
+    fill_n(empty_O.begin(), size, 0);
+    for (auto slot: unoccupied_list) {
+        empty_X[slot.second] |= row_t(1) << slot.first;
+        empty_O[slot.first] |= row_t(1) << slot.second;
     }
 
-    return win_check(current_player);
+    bridge_carriers.clear();
+    bridges_rows_add<row_t>(bitboards.occupied_X.data(), empty_X, false);
+    bridges_rows_add<row_t>(bitboards.occupied_O.data(), empty_O.data(), true);
+}
+
+// With the neighbours of (c, r) at (c - 1, r), (c + 1, r), (c, r - 1),
+// (c + 1, r - 1), (c, r + 1) and (c - 1, r + 1) (see comb_step_down()), the
+// bridges of a stone with the stones of the rows below are, with their
+// carriers:
+// - (c - 1, r + 2), carrier (c, r + 1) and (c - 1, r + 1),
+// - (c - 2, r + 1), carrier (c - 1, r) and (c - 1, r + 1),
+// - (c + 1, r + 1), carrier (c + 1, r) and (c, r + 1).
+// The neighbourhood is the same when rows and columns are swapped, so the
+// same patterns find the bridges of O on its transposed rows.
+template <typename row_t>
+void HexBoard::bridges_rows_add(const row_t* rows, const row_t* empty,
+                                const bool transposed)
+{
+    for (unsigned r = 0; r + 1 < size; ++r) {
+        // Bit c set for each pattern found from the stone at (c, r).
+        row_t vertical = 0;
+        if (r + 2 < size) {
+            vertical = rows[r] & (rows[r + 2] << 1)
+                & empty[r + 1] & (empty[r + 1] << 1);
+        }
+        const row_t left = rows[r] & (rows[r + 1] << 2)
+            & (empty[r] << 1) & (empty[r + 1] << 1);
+        const row_t right = rows[r] & (rows[r + 1] >> 1)
+            & (empty[r] >> 1) & empty[r + 1];
+        if ((vertical | left | right) == 0) {
+            continue;
+        }
+        for (unsigned c = 0; c < size; ++c) {
+            const row_t bit = row_t(1) << c;
+            if (vertical & bit) {
+                bridge_carrier_add(c, r + 1, c - 1, r + 1, transposed);
+            }
+            if (left & bit) {
+                bridge_carrier_add(c - 1, r, c - 1, r + 1, transposed);
+            }
+            if (right & bit) {
+                bridge_carrier_add(c + 1, r, c, r + 1, transposed);
+            }
+        }
+    }
+}
+
+void HexBoard::bridge_carrier_add(unsigned col_a, unsigned row_a,
+                                  unsigned col_b, unsigned row_b,
+                                  const bool transposed)
+{
+    if (transposed) {
+        swap(col_a, row_a);
+        swap(col_b, row_b);
+    }
+    const unsigned a = coord2lin(col_a, row_a);
+    const unsigned b = coord2lin(col_b, row_b);
+    // There are few bridges, a search is cheaper than a map of the slots.
+    for (auto carrier: bridge_carriers) {
+        if ((carrier.first == a) || (carrier.first == b)
+            || (carrier.second == a) || (carrier.second == b)) {
+            return;
+        }
+    }
+    bridge_carriers.push_back(make_pair(a, b));
+}
+
+// Neighbours of the slot (c, r) in order around it, each one a neighbour of the
+// next and the last one of the first: (c + ring_dcol[i], r + ring_drow[i]).
+static const int ring_dcol[6] = {1, 1, 0, -1, -1, 0};
+static const int ring_drow[6] = {0, -1, -1, 0, 1, 1};
+
+// The neighbours of a free slot, as bits of its ring: bits 0 to 5 for the
+// stones and sides of X, bits 6 to 11 for those of O, bits 12 to 17 for the
+// neighbours off the board, beyond a corner, which belong to no side.
+static const unsigned ring_O_shift = 6;
+static const unsigned ring_off_shift = 12;
+
+// True if a player never needs the slot, see HexBoard::inferior_get(). Bit i
+// of own and unusable for neighbour i: a stone or side of the player, and a
+// neighbour the player cannot use.
+static bool ring_useless_check(const unsigned own, const unsigned unusable)
+{
+    for (unsigned a = 0; a < 6; ++a) {
+        for (unsigned b = a + 1; b < 6; ++b) {
+            if (((unusable >> a) & 1) || ((unusable >> b) & 1)) {
+                continue;
+            }
+            // Both ways around the ring, through own neighbours only.
+            bool linked = false;
+            for (unsigned step: {1u, 5u}) {
+                unsigned i = (a + step) % 6;
+                while ((i != b) && ((own >> i) & 1)) {
+                    i = (i + step) % 6;
+                }
+                linked = linked || (i == b);
+            }
+            if (!linked) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// ring_useless_check() of all the rings, indexed by own | unusable << 6.
+static const array<bool, 1 << 12>& ring_useless_table_get()
+{
+    static const array<bool, 1 << 12> table = []() {
+        array<bool, 1 << 12> t;
+        for (unsigned i = 0; i < t.size(); ++i) {
+            t[i] = ring_useless_check(i & 63, i >> 6);
+        }
+        return t;
+    }();
+    return table;
+}
+
+static bool ring_dead_check(const uint32_t ring)
+{
+    const array<bool, 1 << 12>& useless = ring_useless_table_get();
+    const unsigned x = ring & 63;
+    const unsigned o = (ring >> ring_O_shift) & 63;
+    const unsigned off = ring >> ring_off_shift;
+    return useless[x | ((o | off) << 6)] || useless[o | ((x | off) << 6)];
+}
+
+InferiorSlot HexBoard::inferior_get(const unsigned col, const unsigned row)
+{
+    if (occupied_check(col, row)) {
+        return InferiorSlot::NONE;
+    }
+    if (!inferior_valid) {
+        inferior_find();
+    }
+    return inferior_slots[coord2lin(col, row)];
+}
+
+void HexBoard::inferior_slots_remove(vector< pair<unsigned, unsigned> >& moves)
+{
+    if (!inferior_used) {
+        return;
+    }
+    if (!inferior_valid) {
+        inferior_find();
+    }
+    auto inferior = [&](const pair<unsigned, unsigned> move) {
+        return inferior_slots[coord2lin(move.first, move.second)]
+            != InferiorSlot::NONE;
+    };
+    if (all_of(moves.begin(), moves.end(), inferior)) {
+        return;
+    }
+    moves.erase(remove_if(moves.begin(), moves.end(), inferior), moves.end());
+}
+
+void HexBoard::inferior_find()
+{
+    switch (row_bits) {
+    case 16:
+        inferior_find_rows<uint16_t>();
+        break;
+    case 32:
+        inferior_find_rows<uint32_t>();
+        break;
+    default:
+        inferior_find_rows<uint64_t>();
+        break;
+    }
+    inferior_valid = true;
+}
+
+template <typename row_t>
+void HexBoard::inferior_find_rows()
+{
+    HexBitboards<row_t>& bitboards = bitboards_get<row_t>();
+    const row_t full = row_t(~row_t(0)) >> (8 * sizeof(row_t) - size);
+    const row_t last_col = row_t(1) << (size - 1);
+
+    // All in the layout of X: the free slots, and the stones of O.
+    typename HexBitboards<row_t>::rows_t empty;
+    typename HexBitboards<row_t>::rows_t stones_O;
+    const row_t* stones_X = bitboards.occupied_X.data();
+    fill_n(empty.begin(), size, 0);
+    for (auto slot: unoccupied_list) {
+        const unsigned lin = coord2lin(slot.first, slot.second);
+        empty[slot.second] |= row_t(1) << slot.first;
+        inferior_rings[lin] = 0;
+        inferior_slots[lin] = InferiorSlot::NONE;
+    }
+    for (unsigned r = 0; r < size; ++r) {
+        stones_O[r] = full & ~stones_X[r] & ~empty[r];
+    }
+
+    // The rings of a whole row at once: for each neighbour, the rows of X, O
+    // and off the board shifted so that bit c is the neighbour of (c, r).
+    // North and south are the sides of X, west and east those of O.
+    for (unsigned r = 0; r < size; ++r) {
+        if (empty[r] == 0) {
+            continue;
+        }
+        for (unsigned i = 0; i < 6; ++i) {
+            const int neighbour = static_cast<int>(r) + ring_drow[i];
+            row_t x, o;
+            row_t off = 0;
+            if ((neighbour < 0) || (neighbour >= static_cast<int>(size))) {
+                if (ring_dcol[i] > 0) {
+                    off = last_col;
+                } else if (ring_dcol[i] < 0) {
+                    off = 1;
+                }
+                x = full & ~off;
+                o = 0;
+            } else {
+                x = stones_X[neighbour];
+                o = stones_O[neighbour];
+                if (ring_dcol[i] > 0) {
+                    x >>= 1;
+                    o = (o >> 1) | last_col;
+                } else if (ring_dcol[i] < 0) {
+                    x = (x << 1) & full;
+                    o = ((o << 1) & full) | 1;
+                }
+            }
+            for (row_t free = empty[r]; free != 0; free &= free - 1) {
+                const unsigned c = __builtin_ctzll(free);
+                inferior_rings[coord2lin(c, r)]
+                    |= (((x >> c) & 1u) << i)
+                    | (((o >> c) & 1u) << (i + ring_O_shift))
+                    | (((off >> c) & 1u) << (i + ring_off_shift));
+            }
+        }
+    }
+
+    dead_slots.clear();
+    captured_slots[0].clear();
+    captured_slots[1].clear();
+    for (auto slot: unoccupied_list) {
+        const unsigned lin = coord2lin(slot.first, slot.second);
+        if (ring_dead_check(inferior_rings[lin])) {
+            inferior_slots[lin] = InferiorSlot::DEAD;
+            dead_slots.push_back(lin);
+        }
+    }
+
+    // Captured pairs, each one found from its first slot, with its neighbour
+    // east, south-west or south.
+    for (auto slot: unoccupied_list) {
+        const unsigned a = coord2lin(slot.first, slot.second);
+        for (unsigned i: {0u, 4u, 5u}) {
+            if (inferior_slots[a] != InferiorSlot::NONE) {
+                break;
+            }
+            const int col_b = static_cast<int>(slot.first) + ring_dcol[i];
+            const int row_b = static_cast<int>(slot.second) + ring_drow[i];
+            if ((col_b < 0) || (col_b >= static_cast<int>(size))
+                || (row_b >= static_cast<int>(size))
+                || occupied_map[row_b][col_b].is_player()) {
+                continue;
+            }
+            const unsigned b = coord2lin(col_b, row_b);
+            if (inferior_slots[b] != InferiorSlot::NONE) {
+                continue;
+            }
+            // In the ring of b, a is the opposite neighbour.
+            const unsigned j = (i + 3) % 6;
+            for (unsigned p = 0; p < 2; ++p) {
+                const unsigned shift = p * ring_O_shift;
+                if (ring_dead_check(inferior_rings[a] | (1u << (i + shift)))
+                    && ring_dead_check(inferior_rings[b]
+                                       | (1u << (j + shift)))) {
+                    const InferiorSlot captured = (p == 0) ?
+                        InferiorSlot::CAPTURED_X : InferiorSlot::CAPTURED_O;
+                    inferior_slots[a] = captured;
+                    inferior_slots[b] = captured;
+                    captured_slots[p].push_back(a);
+                    captured_slots[p].push_back(b);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void HexBoard::random_engine_select(const RandomEngine engine)
+{
+    const mt19937::result_type seed = random_draw();
+    random_engine = engine;
+    random_seed(seed);
+}
+
+void HexBoard::unoccupied_order_copy(const HexBoard& other)
+{
+    copy(other.unoccupied_list.begin(), other.unoccupied_list.end(),
+         unoccupied_list.begin());
+    copy(other.unoccupied_index.begin(), other.unoccupied_index.end(),
+         unoccupied_index.begin());
+}
+
+void HexBoard::random_seed(const mt19937::result_type seed)
+{
+    switch (random_engine) {
+    case RandomEngine::MT19937:
+        random_mt19937.seed(seed);
+        break;
+    case RandomEngine::PCG32:
+        random_pcg32.seed(seed);
+        break;
+    default:
+        random_xoshiro256.seed(seed);
+        break;
+    }
+}
+
+mt19937::result_type HexBoard::random_draw()
+{
+    switch (random_engine) {
+    case RandomEngine::MT19937:
+        return random_mt19937();
+    case RandomEngine::PCG32:
+        return random_pcg32();
+    default:
+        return random_xoshiro256() >> 32;
+    }
+}
+
+unsigned HexBoard::random_below(const unsigned range)
+{
+    switch (random_engine) {
+    case RandomEngine::MT19937:
+        return ::random_below(random_mt19937, range);
+    case RandomEngine::PCG32:
+        return ::random_below(random_pcg32, range);
+    default:
+        return ::random_below(random_xoshiro256, range);
+    }
 }
 
 bool HexBoard::win_check(const Player player)
 {
-    vector<uint16_t>& occupied = (player.get() == player_e::O) ?
-        occupied_O :
-        occupied_X;
+    switch (row_bits) {
+    case 16:
+        return win_check_rows<uint16_t>(player);
+    case 32:
+        return win_check_rows<uint32_t>(player);
+    default:
+        return win_check_rows<uint64_t>(player);
+    }
+}
 
-    vector<uint16_t> combed(size);
+// Bits 0 to nb_bits - 1 of row, in reverse order.
+static inline uint64_t row_reverse(uint64_t row, const unsigned nb_bits)
+{
+    row = ((row >> 1) & 0x5555555555555555ULL)
+        | ((row & 0x5555555555555555ULL) << 1);
+    row = ((row >> 2) & 0x3333333333333333ULL)
+        | ((row & 0x3333333333333333ULL) << 2);
+    row = ((row >> 4) & 0x0f0f0f0f0f0f0f0fULL)
+        | ((row & 0x0f0f0f0f0f0f0f0fULL) << 4);
+    return __builtin_bswap64(row) >> (64 - nb_bits);
+}
+
+bool HexBoard::symmetric_check()
+{
+    switch (row_bits) {
+    case 16:
+        return symmetric_check_rows<uint16_t>();
+    case 32:
+        return symmetric_check_rows<uint32_t>();
+    default:
+        return symmetric_check_rows<uint64_t>();
+    }
+}
+
+// The rotation maps row i to row size - 1 - i, reversed. This holds for the
+// transposed bitboard of O as well, so both are checked the same way.
+template <typename row_t>
+bool HexBoard::symmetric_check_rows()
+{
+    const HexBitboards<row_t>& bitboards = bitboards_get<row_t>();
+    for (unsigned i = 0; i < (size + 1) / 2; ++i) {
+        const unsigned j = size - 1 - i;
+        if ((row_reverse(bitboards.occupied_X[i], size)
+             != bitboards.occupied_X[j])
+            || (row_reverse(bitboards.occupied_O[i], size)
+                != bitboards.occupied_O[j])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename row_t>
+bool HexBoard::win_check_rows(const Player player)
+{
+    TRACE_COUNT(win_checks, 1);
+    TRACE_TIME(win_check_ns);
+    HexBitboards<row_t>& bitboards = bitboards_get<row_t>();
+    const row_t* occupied = (player.get() == player_e::O) ?
+        bitboards.occupied_O.data() :
+        bitboards.occupied_X.data();
+
+    // Rows are combed into from the row above, start from scratch.
+    row_t* combed = bitboards.combed.data();
+    fill_n(combed, size, 0);
 
     // Was the current row modified by a go-back-up operation?
     bool previous_modified = false;
 
     combed[0] = occupied[0];
     unsigned i = 0;
-    while ((combed[i] != 0) && (i < size)) {
+    while (combed[i] != 0) {
+        if (i == size - 1) {
+            // Reached the last row, there is no row below to comb into.
+            return true;
+        }
         // Connections 3 and 9 o'clock on this row.
         // Nothing happens at the first row since combed[0] is initialized as
         // occupied[0].
@@ -225,47 +871,53 @@ bool HexBoard::win_check(const Player player)
             // previous step, since there could be a new diagonal connection.
             // The first row cannot be modified, because of its initialization.
             previous_modified = comb_step_up(combed, occupied, i);
+            TRACE_COUNT(comb_steps_up, 1);
             if (previous_modified) {
                 --i;    // keep going upwards.
             } else {
                 // Nothing new, go on.
                 comb_step_down(combed, occupied, i);
+                TRACE_COUNT(comb_steps_down, 1);
                 ++i;
             }
         } else {
             // Connections 5 and 7 o'clock from this row.
             comb_step_down(combed, occupied, i);
+            TRACE_COUNT(comb_steps_down, 1);
             ++i;
         }
     }
-    return combed[size - 1] != 0;
+    return false;
 }
 
 
-static inline void comb_step_down(vector<uint16_t>& combed,
-                                  vector<uint16_t> const& occupied,
+template <typename row_t>
+static inline void comb_step_down(row_t* combed,
+                                  const row_t* occupied,
                                   const unsigned i)
 {
     combed[i + 1] |= combed[i] | (combed[i] >> 1u);
     combed[i + 1] &= occupied[i + 1];
 }
 
-static inline bool comb_step_up(vector<uint16_t>& combed,
-                                vector<uint16_t> const& occupied,
+template <typename row_t>
+static inline bool comb_step_up(row_t* combed,
+                                const row_t* occupied,
                                 const unsigned i)
 {
-    uint16_t old_previous_row = combed[i - 1];
+    row_t old_previous_row = combed[i - 1];
     combed[i - 1] |= combed[i] | (combed[i] << 1u);
     combed[i - 1] &= occupied[i - 1];
     return old_previous_row != combed[i - 1];
 }
 
-static inline bool comb_laterally_spread(vector<uint16_t>& combed,
-                                         vector<uint16_t> const& occupied,
+template <typename row_t>
+static inline bool comb_laterally_spread(row_t* combed,
+                                         const row_t* occupied,
                                          const unsigned i)
 {
-    uint16_t old_combed = combed[i];    // To see if there was actual spread.
-    uint16_t tmp_combed;
+    row_t old_combed = combed[i];    // To see if there was actual spread.
+    row_t tmp_combed;
     do {
         tmp_combed = combed[i];
         combed[i] |= (combed[i] << 1u) & occupied[i];
@@ -290,55 +942,125 @@ void HexBoard::occupied_list_get(const Player player, vector<int>& list)
 
 void HexBoard::player_select(const Player player)
 {
-    current_player = player;
-    if (player.get() == player_e::O) {
-        HexBoard::occupied_player_set = &HexBoard::occupied_O_set;
-    } else if (player.get() == player_e::X) {
-        HexBoard::occupied_player_set = &HexBoard::occupied_X_set;
-    } else {
+    if (!player.is_player()) {
         cerr << __func__ << ": undefined player." << endl;
         exit(1);
     }
+    current_player = player;
+}
+
+void HexBoard::occupied_save()
+{
+    switch (row_bits) {
+    case 16:
+        occupied_save_rows<uint16_t>();
+        break;
+    case 32:
+        occupied_save_rows<uint32_t>();
+        break;
+    default:
+        occupied_save_rows<uint64_t>();
+        break;
+    }
+}
+
+void HexBoard::occupied_restore()
+{
+    switch (row_bits) {
+    case 16:
+        occupied_restore_rows<uint16_t>();
+        break;
+    case 32:
+        occupied_restore_rows<uint32_t>();
+        break;
+    default:
+        occupied_restore_rows<uint64_t>();
+        break;
+    }
+}
+
+template <typename row_t>
+void HexBoard::occupied_save_rows()
+{
+    HexBitboards<row_t>& bitboards = bitboards_get<row_t>();
+    const typename HexBitboards<row_t>::rows_t& occupied
+        = (current_player.get() == player_e::X)
+        ? bitboards.occupied_X
+        : bitboards.occupied_O;
+    copy_n(occupied.begin(), size, bitboards.saved.begin());
+}
+
+template <typename row_t>
+void HexBoard::occupied_restore_rows()
+{
+    HexBitboards<row_t>& bitboards = bitboards_get<row_t>();
+    typename HexBitboards<row_t>::rows_t& occupied
+        = (current_player.get() == player_e::X)
+        ? bitboards.occupied_X
+        : bitboards.occupied_O;
+    copy_n(bitboards.saved.begin(), size, occupied.begin());
 }
 
 void HexBoard::occupied_set(unsigned col, unsigned row, Player player,
                             int value)
 {
+    bridges_valid = false;
+    inferior_valid = false;
+    if (player.is_player()) {
+        hash ^= stone_key_get(col, row, player);
+        hash_rotated ^= stone_key_get(size - 1 - col, size - 1 - row, player);
+    }
+
     if (value > 0) {
         // order of row and col here inverted, occupied_map is a vector of rows.
         occupied_map[row][col] = player;
-        auto it = find(unoccupied_list.begin(), unoccupied_list.end(),
-                       make_pair(col, row));
-        unoccupied_list.erase(it);
+        // Swap-remove: the last slot of the list takes the place of this one.
+        unsigned i = unoccupied_index[coord2lin(col, row)];
+        pair<unsigned, unsigned> last = unoccupied_list.back();
+        unoccupied_list[i] = last;
+        unoccupied_index[coord2lin(last.first, last.second)] = i;
+        unoccupied_list.pop_back();
+    } else {
+        occupied_map[row][col] = player_e::NONE;
+        unoccupied_index[coord2lin(col, row)] = unoccupied_list.size();
+        unoccupied_list.push_back(make_pair(col, row));
+    }
+
+    switch (row_bits) {
+    case 16:
+        occupied_bit_set<uint16_t>(col, row, player, value);
+        break;
+    case 32:
+        occupied_bit_set<uint32_t>(col, row, player, value);
+        break;
+    default:
+        occupied_bit_set<uint64_t>(col, row, player, value);
+        break;
+    }
+}
+
+template <typename row_t>
+void HexBoard::occupied_bit_set(unsigned col, unsigned row, Player player,
+                                int value)
+{
+    HexBitboards<row_t>& bitboards = bitboards_get<row_t>();
+    if (value > 0) {
         if (player.get() == player_e::X) {
-            occupied_X[row] |= (1 << col);
+            bitboards.occupied_X[row] |= (row_t(1) << col);
         } else if (player.get() == player_e::O) {
             // col and row are inverted for common win_check().
-            occupied_O[col] |= (1 << row);
+            bitboards.occupied_O[col] |= (row_t(1) << row);
         }
-
     } else {
-        occupied_map[row][col] = player_e::NONE;
-        unoccupied_list.push_back(make_pair(col, row));
         if (player.get() == player_e::X) {
-            occupied_X[row] &= ~(1 << col);
+            bitboards.occupied_X[row] &= ~(row_t(1) << col);
         } else if (player.get() == player_e::O) {
             // col and row are inverted for common win_check().
-            occupied_O[col] &= ~(1 << row);
+            bitboards.occupied_O[col] &= ~(row_t(1) << row);
         }
     }
 }
 
-inline void HexBoard::occupied_X_set(unsigned col, unsigned row)
-{
-    occupied_X[row] |= (1 << col);
-}
-
-inline void HexBoard::occupied_O_set(unsigned col, unsigned row)
-{
-    occupied_O[col] |= (1 << row);
-}
-
 // -----------------------------------------------------------------------------
 // Print operations
 // -----------------------------------------------------------------------------
@@ -4,20 +4,67 @@ Implementation of a hex board
 #ifndef HEXBOARD_HPP_INCLUDED
 #define HEXBOARD_HPP_INCLUDED
 
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <random>
 #include <vector>
 #include "graph.hpp"
+#include "hexgroups.hpp"
 #include "player.hpp"
+#include "random.hpp"
 
 using std::vector;
 
 extern const int nb_players;
 
+// Largest board side supported, limited by the widest bitboard row.
+const unsigned hexboard_max_size = 64;
+
+// Bitboards of the two players, see HexBoard::bitboards_16 below. row_t is an
+// unsigned integer type, with at least as many bits as the board side.
+// The rows are stored inline, sized for the largest board of that width, so
+// that the simulations never allocate memory. Only the first size rows are
+// used.
+template <typename row_t>
+struct HexBitboards {
+    typedef array<row_t, 8 * sizeof(row_t)> rows_t;
+
+    rows_t occupied_X;
+    rows_t occupied_O;
+    // Copy of the bitboard of one player, see HexBoard::occupied_save().
+    rows_t saved;
+    // Scratch rows for win_check().
+    rows_t combed;
+};
+
+// Random keys of the Zobrist hash of the positions, see HexBoard::hash_get().
+// One per player and slot, one per board size, and one for O to move. The
+// keys are the same in every run, so that hashes can be stored (opening
+// book).
+struct ZobristKeys {
+    uint64_t stones[2][hexboard_max_size * hexboard_max_size];
+    uint64_t sizes[hexboard_max_size + 1];
+    uint64_t O_to_move;
+};
+
+const ZobristKeys& zobrist_keys_get();
+
+// Random engines available for the simulations, see random.hpp.
+enum class RandomEngine { MT19937, PCG32, XOSHIRO256 };
+
+// How the playouts fill the board, see HexBoard::playout_policy_select().
+enum class PlayoutPolicy { UNIFORM, BRIDGES };
+
+// Free slots that the search can leave out, see HexBoard::inferior_get().
+enum class InferiorSlot : uint8_t { NONE, DEAD, CAPTURED_X, CAPTURED_O };
+
 class HexBoard {
 public:
+    // The random engine of the simulations is seeded from the time, or from
+    // seed to make the simulations reproducible.
     HexBoard(unsigned size);
+    HexBoard(unsigned size, const mt19937::result_type seed);
 
     // Play a move, returns true if the game was won.
     bool play(const unsigned col, const unsigned row, const Player player);
@@ -40,35 +87,190 @@ public:
 
     void player_select(const Player player);
 
+    // Keep the groups of connected stones up to date as stones are placed and
+    // removed. play() then detects a win from the groups instead of combing
+    // the whole board. Off by default: on the board sizes played, combing the
+    // bitboards is as fast, and the simulations do not need the groups.
+    void groups_track(const bool enable);
+
+    // Group of the stone at the given slot, see HexGroups::group_get().
+    // Requires groups_track(true).
+    unsigned group_get(const unsigned col, const unsigned row) const {
+        return groups.group_get(col, row);
+    }
+
+    // Random engine of the simulations, to trade quality for speed. The
+    // default is PCG32. Selecting an engine seeds it from the previous
+    // one, so that a seeded board stays reproducible.
+    void random_engine_select(const RandomEngine engine);
+
+    // Policy of the playouts of fill_up_half_and_win_check() and
+    // fill_up_half():
+    // - UNIFORM, the default: the stones of the current player go to a
+    //   uniformly random half of the free slots.
+    // - BRIDGES: a bridge is two stones of a player with two common free
+    //   neighbours, its carrier. In a playout move by move, the owner of a
+    //   bridge answers an intrusion into the carrier by taking the other slot.
+    //   The fill has no move order, so each carrier of the bridges on the
+    //   board gets one stone of each player instead, at random, and the rest
+    //   is uniform. Carriers shared by several bridges are split once.
+    void playout_policy_select(const PlayoutPolicy policy) {
+        playout_policy = policy;
+    }
+
+    // Inferior slots, free slots whose stone does not matter:
+    // - DEAD: the winner is the same whoever takes the slot. A player never
+    //   needs a slot if any two of its neighbours the player can use (free,
+    //   own stones, own sides) are neighbours, or linked by a run of own
+    //   stones and sides around the slot: a chain through the slot can go
+    //   around it. The slot is then dead, as a full board has exactly one
+    //   winner.
+    // - CAPTURED_X, CAPTURED_O: two neighbour slots, each dead once the
+    //   player has the other. The player answers a stone of the other player
+    //   on one by taking the other, and so owns both.
+    // The patterns are matched on the six neighbours of the slots, from the
+    // bitboards. They are found on the first call after the stones changed.
+    // NONE for occupied slots. Not valid during a playout.
+    InferiorSlot inferior_get(const unsigned col, const unsigned row);
+
+    // Use the inferior slots: the playouts give the captured slots to their
+    // owner and the dead ones to either player, and only draw the others,
+    // and inferior_slots_remove() prunes them from the moves to search. Off
+    // by default.
+    void inferior_slots_use(const bool enable) {
+        inferior_used = enable;
+    }
+
+    // When the inferior slots are used, remove them from moves, unless no
+    // move would be left.
+    void inferior_slots_remove(vector< pair<unsigned, unsigned> >& moves);
+
+    // Reseed the random engine used by the simulations. Copies of a board
+    // share the state of the engine at copy time, reseed them to get
+    // independent sequences.
+    void random_seed(const mt19937::result_type seed);
+
+    // Draw a 32 bit number from the random engine of the board, e.g. to
+    // derive seeds for other engines.
+    mt19937::result_type random_draw();
+
+    // Put the free slots back in the order of those of other, a board of the
+    // same size with the same stones, e.g. the one this board was copied
+    // from: the playouts then draw the same slots for the same seed, whatever
+    // ran on this board before. No allocation.
+    void unoccupied_order_copy(const HexBoard& other);
+
     // Destructive. Once this function is called, the content of the member
     // variable occupied_X or _O is not valid, depending on player.
     // Use the function occupied_save and occupied_restore to revert to a known
     // state.
-    // The unoccupied member has been shuffled, but its content has not been
-    // otherwise changed.
+    // The unoccupied member has been partly shuffled, but its content has not
+    // been otherwise changed.
     bool fill_up_half_and_win_check();
     void fill_up(const Player first_player);
 
+    // First half of fill_up_half_and_win_check(): fill up, without checking
+    // for a win. Same warnings. For PlayoutBatch, which checks many boards at
+    // once.
+    void fill_up_half();
+
+    // Bitboard of the current player, for boards of 16 rows or less (see
+    // PlayoutBatch).
+    const uint16_t* playout_rows_get() const {
+        return (current_player.get() == player_e::O)
+            ? bitboards_16.occupied_O.data()
+            : bitboards_16.occupied_X.data();
+    }
+
+    // Number of stones placed by the last fill up of the current player: they
+    // are on the first slots of unoccupied_list_get(), until the stones or the
+    // list change. For the statistics of the moves of the playouts (AMAF).
+    unsigned playout_nb_stones_get() const {
+        return unoccupied_list.size() / 2;
+    }
+
     bool win_check(const Player player);
 
-    vector<uint16_t>& occupied_save() {
-        return (current_player.get() == player_e::X)
-            ? occupied_X
-            : occupied_O;
+    // Save the bitboard of the current player (see player_select()), to be
+    // restored by occupied_restore() after fill_up_half_and_win_check().
+    void occupied_save();
+    void occupied_restore();
+
+    // Zobrist hash of the stones on the board, and of the board size. It is
+    // kept up to date as stones are placed and removed, but not by the fills
+    // of the playouts. The same stones give the same hash, whatever the order
+    // they were placed in.
+    uint64_t hash_get() const {
+        return hash;
+    }
+
+    // Hash of the position with player to move, to tell apart the positions
+    // with the same stones but a different player to move.
+    uint64_t hash_get(const Player to_move) const {
+        return (to_move.get() == player_e::O) ?
+            hash ^ zobrist->O_to_move : hash;
     }
 
-    void occupied_restore(vector<uint16_t>& src) {
-        if (current_player.get() == player_e::X) {
-            occupied_X = src;
-        } else {
-            occupied_O = src;
-        }
+    // Hash of the position after player places a stone on the given slot,
+    // with the other player to move, without placing it.
+    uint64_t hash_after_get(const pair<unsigned, unsigned> coord,
+                            const Player player) const {
+        Player next = player;
+        next.swap();
+        return hash_get(next) ^ stone_key_get(coord.first, coord.second,
+                                              player);
     }
 
-    // Return a list of all unoccupied slots. The reference may modify the
-    // content of the class member! This is a bit dangerous, but gives a
-    // significant optimization opportunity.
-    vector< pair<unsigned, unsigned> >& unoccupied_list_get() {
+    // Symmetry: a Hex board is the same for both players after a rotation of
+    // 180 degrees, slot (col, row) going to (size - 1 - col, size - 1 - row).
+    // A position and its rotation have the same value, and so do a move and
+    // its rotation in a symmetric position.
+
+    // Slot of coord after the rotation. The rotation is its own inverse.
+    pair<unsigned, unsigned> rotated_get(
+        const pair<unsigned, unsigned> coord) const {
+        return make_pair(size - 1 - coord.first, size - 1 - coord.second);
+    }
+
+    // True if the stones are the same after the rotation, compared on the
+    // bitboards. Not valid during a playout.
+    bool symmetric_check();
+
+    // Of a position and its rotation, the canonical one is that with the
+    // smallest hash. Both have the same canonical hash, for the caches to
+    // share their entries. Player to move as for hash_get().
+    uint64_t canonical_hash_get(const Player to_move) const {
+        const uint64_t stones = min(hash, hash_rotated);
+        return (to_move.get() == player_e::O) ?
+            stones ^ zobrist->O_to_move : stones;
+    }
+
+    // Canonical hash of the position after player places a stone on the given
+    // slot, with the other player to move, see hash_after_get().
+    uint64_t canonical_hash_after_get(const pair<unsigned, unsigned> coord,
+                                      const Player player) const {
+        const pair<unsigned, unsigned> rotated = rotated_get(coord);
+        const uint64_t stones = min(
+            hash ^ stone_key_get(coord.first, coord.second, player),
+            hash_rotated ^ stone_key_get(rotated.first, rotated.second,
+                                         player));
+        return (player.get() == player_e::X) ?
+            stones ^ zobrist->O_to_move : stones;
+    }
+
+    // Slot of coord on the canonical form of the board: coord itself, or its
+    // rotation if the canonical form is the rotated board. A move stored
+    // under the canonical hash (opening book) maps back to this board in
+    // the same way.
+    pair<unsigned, unsigned> canonical_move_get(
+        const pair<unsigned, unsigned> coord) const {
+        return (hash_rotated < hash) ? rotated_get(coord) : coord;
+    }
+
+    // Return a list of all unoccupied slots, in no particular order. The
+    // order changes when stones are placed or removed, and when the list is
+    // shuffled by the simulations.
+    const vector< pair<unsigned, unsigned> >& unoccupied_list_get() const {
         return unoccupied_list;
     }
 
@@ -114,31 +316,130 @@ protected:
     // information, but maintaining it here in this form removes the need to
     // compute it many times when running an AI on the board.
     vector< pair<unsigned, unsigned> > unoccupied_list;
+    // Position of each slot in unoccupied_list, indexed by coord2lin(). Only
+    // meaningful for unoccupied slots. A stone is placed by moving the last
+    // entry of the list in place of the slot, and removed by appending the
+    // slot, both in constant time.
+    vector<unsigned> unoccupied_index;
+
+    // Swap two entries of unoccupied_list, keeping unoccupied_index up to
+    // date.
+    void unoccupied_swap(const unsigned i, const unsigned j) {
+        swap(unoccupied_list[i], unoccupied_list[j]);
+        unoccupied_index[coord2lin(unoccupied_list[i].first,
+                                   unoccupied_list[i].second)] = i;
+        unoccupied_index[coord2lin(unoccupied_list[j].first,
+                                   unoccupied_list[j].second)] = j;
+    }
 
     // These are used for an optimized monte-carlo simulation. A bit to 1 means
     // this player has a stone at that position. For occupied_X, the first
-    // uint16 is the highest row of the board. For occupied_O, it is the
+    // word is the highest row of the board. For occupied_O, it is the
     // left-most column.
-    // bit 0 of the the uint16 is column 0 for occupied_X, row 0 for
+    // bit 0 of the the word is column 0 for occupied_X, row 0 for
     // occupied_O. Note that if you think of bit 0 as the right-most bit, this
-    // means these uint16s are left-right mirrored compared to the actual board.
+    // means these words are left-right mirrored compared to the actual board.
     // This helps optimization, and gives the same number for bit and column/row.
-    vector<uint16_t> occupied_X;
-    vector<uint16_t> occupied_O;
+    // The words are the narrowest type that holds a row, given by row_bits.
+    // Only the bitboards of that width are used, the others stay empty. The
+    // functions working on them are templates instantiated per width, and
+    // dispatched on row_bits.
+    unsigned row_bits;
+    HexBitboards<uint16_t> bitboards_16;
+    HexBitboards<uint32_t> bitboards_32;
+    HexBitboards<uint64_t> bitboards_64;
+
+    template <typename row_t>
+    HexBitboards<row_t>& bitboards_get();
+
+    // See hash_get(). The keys are shared by all the boards.
+    const ZobristKeys* zobrist;
+    uint64_t hash;
+    // Hash of the rotated board, kept up to date along with hash.
+    uint64_t hash_rotated;
+
+    uint64_t stone_key_get(const unsigned col, const unsigned row,
+                           const Player player) const {
+        return zobrist->stones[player.get() == player_e::O]
+            [row * hexboard_max_size + col];
+    }
+
+    // Connectivity of the stones, when groups_tracked.
+    bool groups_tracked;
+    HexGroups groups;
 
     // Indeces to the winning board sides (virtual nodes) of the current player.
     int side_a, side_b;
 
-    mt19937 random_engine;
+    PlayoutPolicy playout_policy;
+    // Carriers of the bridges of both players, as pairs of coord2lin()
+    // slots, pairwise distinct. Found on the first playout after the stones
+    // changed.
+    vector< pair<unsigned, unsigned> > bridge_carriers;
+    bool bridges_valid;
+
+    // Fill bridge_carriers from the bitboards.
+    void bridges_find();
+    template <typename row_t>
+    void bridges_find_rows();
+    // Add the carriers of the bridges of the stones of rows, with empty the
+    // free slots in the same layout.
+    template <typename row_t>
+    void bridges_rows_add(const row_t* rows, const row_t* empty,
+                          const bool transposed);
+    // Add a carrier, unless one of its slots is already in another one.
+    void bridge_carrier_add(unsigned col_a, unsigned row_a,
+                            unsigned col_b, unsigned row_b,
+                            const bool transposed);
+
+    bool inferior_used;
+    // Analysis of the free slots, indexed by coord2lin(), and the lists of
+    // the dead slots and of the slots captured by X and by O. Found on the
+    // first playout after the stones changed.
+    vector<InferiorSlot> inferior_slots;
+    vector<unsigned> dead_slots;
+    vector<unsigned> captured_slots[2];
+    bool inferior_valid;
+    // Scratch of inferior_find(): the neighbours of each free slot.
+    vector<uint32_t> inferior_rings;
+
+    // Fill the inferior slots from the bitboards.
+    void inferior_find();
+    template <typename row_t>
+    void inferior_find_rows();
+
+    // Only the selected engine is used and seeded.
+    RandomEngine random_engine;
+    mt19937 random_mt19937;
+    Pcg32 random_pcg32;
+    Xoshiro256 random_xoshiro256;
+
+    // Uniform number in [0, range) from the selected engine.
+    unsigned random_below(const unsigned range);
 
     void occupied_set(unsigned col, unsigned row, Player player, int value = 1);
     void occupied_reset(unsigned col, unsigned row, Player player) {
         occupied_set(col, row, player, 0);
     }
 
-    void occupied_X_set(unsigned col, unsigned row);
-    void occupied_O_set(unsigned col, unsigned row);
-    void (HexBoard::*occupied_player_set)(unsigned, unsigned);
+    template <typename row_t>
+    void occupied_bit_set(unsigned col, unsigned row, Player player,
+                          int value);
+
+    template <typename row_t>
+    bool fill_up_half_and_win_check_rows();
+    template <typename row_t>
+    void fill_up_half_rows();
+    template <typename row_t, typename Engine>
+    void fill_up_half_rows(Engine& engine);
+    template <typename row_t>
+    bool win_check_rows(const Player player);
+    template <typename row_t>
+    bool symmetric_check_rows();
+    template <typename row_t>
+    void occupied_save_rows();
+    template <typename row_t>
+    void occupied_restore_rows();
 
     // Convert a column and row pair to a linear index, which is used as a node
     // name in the graph.
@@ -153,6 +454,24 @@ protected:
     }
 };
 
+template <>
+inline HexBitboards<uint16_t>& HexBoard::bitboards_get<uint16_t>()
+{
+    return bitboards_16;
+}
+
+template <>
+inline HexBitboards<uint32_t>& HexBoard::bitboards_get<uint32_t>()
+{
+    return bitboards_32;
+}
+
+template <>
+inline HexBitboards<uint64_t>& HexBoard::bitboards_get<uint64_t>()
+{
+    return bitboards_64;
+}
+
 ostream& operator<< (ostream& os, const HexBoard& h);
 void move_print(const pair<unsigned, unsigned> move);
 
@@ -0,0 +1,100 @@
+/*------------------------------------------------------------------------------
+  hexbook.cpp
+  Generate the opening book of hexjakt, see openingbook.hpp. This runs deep
+  searches, for all the positions of the first moves: expect minutes per
+  board size.
+  ------------------------------------------------------------------------------*/
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <unistd.h> // getopt
+#include <vector>
+
+#include "hexboard.hpp"
+#include "openingbook.hpp"
+
+using namespace std;
+
+static void usage_print()
+{
+    cout << "Usage:" << endl;
+    cout << "hexbook [options] -o file size [size...]" << endl;
+    cout << "- write the opening book of the board sizes to file" << endl;
+    cout << endl;
+    cout << "options:" << endl;
+    cout << "    -o file: the book file to write." << endl;
+    cout << "    -d moves: number of moves of the games covered by the book"
+         << " (default 3)." << endl;
+    cout << "    -n iter: Monte-Carlo iterations per test move of each search"
+         << " (default 10000)." << endl;
+    cout << "    -t threads: number of threads of the searches, 0 for one per"
+         << " core (default 0)." << endl;
+    cout << "    -s seed: seed of the searches (default 1)." << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    string filename;
+    unsigned nb_moves = 3;
+    unsigned simulations_per_test = 10000;
+    unsigned nb_threads = 0;
+    unsigned long seed = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "o:d:n:t:s:")) != -1) {
+        stringstream ss;
+        if (optarg != nullptr) {
+            ss << optarg;
+        }
+        switch (opt) {
+        case 'o':
+            filename = optarg;
+            break;
+        case 'd':
+            ss >> nb_moves;
+            break;
+        case 'n':
+            ss >> simulations_per_test;
+            break;
+        case 't':
+            ss >> nb_threads;
+            break;
+        case 's':
+            ss >> seed;
+            break;
+        default:
+            usage_print();
+            return -1;
+        }
+    }
+    if (filename.empty() || (optind >= argc)) {
+        usage_print();
+        return -1;
+    }
+    if (nb_threads == 0) {
+        nb_threads = max(thread::hardware_concurrency(), 1u);
+    }
+
+    OpeningBookGenerator generator(nb_moves, simulations_per_test, nb_threads,
+                                   seed);
+    generator.progress_set(&cerr);
+    for (int i = optind; i < argc; ++i) {
+        const unsigned size = atoi(argv[i]);
+        if ((size < 3) || (size > hexboard_max_size)) {
+            cerr << "E: board size must be 3 to " << hexboard_max_size
+                 << ": " << argv[i] << endl;
+            return -2;
+        }
+        generator.size_add(size);
+    }
+
+    const vector<OpeningBookEntry> entries = generator.entries_get();
+    if (!OpeningBook::write(filename, entries)) {
+        cerr << "E: cannot write " << filename << endl;
+        return -3;
+    }
+    cout << entries.size() << " positions written to " << filename << endl;
+    return 0;
+}
@@ -1,13 +1,19 @@
 /*------------------------------------------------------------------------------
 Hex game class implementation
 ------------------------------------------------------------------------------*/
+#include <algorithm>
+#include <cctype>
 #include <chrono>
 #include <iostream>
+#include <sstream>
+#include <string>
 #include <utility> // pair
 
 #include "hexboard.hpp"
 #include "hexgame.hpp"
 #include "moveeval.hpp"
+#include "trace.hpp"
+#include "uctsearch.hpp"
 
 enum {
     FLAG_NO_READ = 1
@@ -61,26 +67,33 @@ int HexGame::autoplay_handshake(const char color)
 {
     // send handshake message color: name of program by author
     // this string should uniquely identify the player
-    cout << color
-         << ": Hexjakt by Gauthier Östervall, https://github.com/fleutot/hex"
-         << endl;
+    protocol_out << color
+                 << ": Hexjakt by Gauthier Östervall,"
+                 << " https://github.com/fleutot/hex\n";
+    protocol_out.flush();
 
     if(color == 'X') {
-        char c;
-        // wait for other player's handshake message
-        cin >> c; // should be the other player's color
-        if(c != 'O') {
+        // wait for other player's handshake message, the first line that is
+        // not blank.
+        string line;
+        size_t i;
+        do {
+            if (protocol_in.line_read(line) == ProtocolRead::END) {
+                cerr << "X. E: expecting handshake message from O" << endl;
+                return -2;
+            }
+            i = line.find_first_not_of(" \t\r");
+        } while (i == string::npos);
+        if(line[i] != 'O') { // should be the other player's color
             cerr << "X. E: expecting handshake message from O" << endl;
             return -2;
         }
-        cin >> c; // should be ':'
-        if(c != ':') {
+        i = line.find_first_not_of(" \t\r", i + 1);
+        if((i == string::npos) || (line[i] != ':')) {
             cerr << "X. E: expecting : after O in handshake message" << endl;
             return -3;
         }
-        // ignore the rest of the line
-        cin.clear();
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        // the rest of the line is ignored
     }
     return 0;
 }
@@ -95,9 +108,13 @@ bool HexGame::autoplay_next_move_play()
     if (current_player_type_get() == PlayerType::AI) {
         error_code = autoplay_input_move_make(move, elapsed_milli);
     } else if (current_player_type_get() == PlayerType::OPPONENT_AI) {
+        // Think on the time of the opponent. The move is read meanwhile, the
+        // search stops within an iteration once it is there.
+        ponder_start();
         do {
             error_code = autoplay_opponent_move_read(move, opponent_give_up);
-        } while (error_code != 0);
+        } while (error_code == FLAG_NO_READ);
+        ponder_end();
     }
 
     if (error_code < 0) {
@@ -109,7 +126,7 @@ bool HexGame::autoplay_next_move_play()
         return true;
     }
 
-    bool win = board.play(move, current_player);
+    bool win = move_play(move);
 
     if (current_player_type_get() == PlayerType::AI) {
         autoplay_move_print(move, win, elapsed_milli);
@@ -126,22 +143,23 @@ bool HexGame::autoplay_next_move_play()
 void HexGame::autoplay_move_print(pair<unsigned, unsigned> const& move,
                                   const bool win, const double elapsed_milli)
 {
-    static unsigned move_count = 0;
-    // Output for this new move.
-    cout << current_player;
-    move_print(move);
+    // Output for this new move, written out at once.
+    protocol_out << current_player
+                 << static_cast<char>(move.first + 'a') << move.second + 1;
     if (win) {
-        cout << ".";
+        protocol_out << ".";
     } else {
-        cout << " ";
+        protocol_out << " ";
     }
-    cout << "#" << ++move_count << " ";
-    cout << "t=" << static_cast<int>(elapsed_milli) << "ms" << endl;
+    protocol_out << "#" << ++nb_moves_printed << " ";
+    protocol_out << "t=" << static_cast<unsigned>(elapsed_milli) << "ms\n";
+    protocol_out.flush();
 }
 
 void HexGame::autoplay_capitulate_print()
 {
-    cout << current_player << "." << endl;
+    protocol_out << current_player << ".\n";
+    protocol_out.flush();
 }
 
 bool HexGame::next_prompt_and_play()
@@ -165,7 +183,7 @@ bool HexGame::next_prompt_and_play()
         }
     } while (!valid_move);
 
-    bool win = board.play(move, current_player);
+    bool win = move_play(move);
 
     if (win) {
         winner = current_player;
@@ -195,12 +213,27 @@ PlayerType HexGame::current_player_type_get()
     }
 }
 
+bool HexGame::move_play(const pair<unsigned, unsigned> move)
+{
+    // Unauthorized moves are refused by the board, the tree must not see them
+    // either.
+    const bool valid = (move.first < board.size_get())
+        && (move.second < board.size_get())
+        && !board.occupied_check(move.first, move.second);
+
+    bool win = board.play(move, current_player);
+    if (valid) {
+        search.advance(move);
+    }
+    return win;
+}
+
 // Get the input pair in 0 based integers, return false if there was an error.
 bool HexGame::human_input_get(pair<unsigned, unsigned>& move)
 {
     string in;
     cin >> in;
-    unsigned col = toupper(in[0]) - 'A';
+    unsigned col = toupper(static_cast<unsigned char>(in[0])) - 'A';
 
     // Make the first char of the string a leading 0 (as suggested in the
     // forums).
@@ -225,96 +258,196 @@ bool HexGame::ai_input_get(pair<unsigned, unsigned>& move)
 {
     cout << "thinking... " << flush;
 
-    chrono::time_point<chrono::system_clock> start, end;
-    start = chrono::system_clock::now();
+    chrono::time_point<chrono::steady_clock> start, end;
+    start = chrono::steady_clock::now();
 
-    MoveEvaluator evaluator(board, current_player, max_simulations,
-                            simulations_per_test_move);
-    move = evaluator.best_move_calculate();
+    move = ai_move_calculate(start);
     cout << " -> ";
     move_print(move);
     cout << endl;
 
-    end = chrono::system_clock::now();
+    end = chrono::steady_clock::now();
     chrono::duration<double> elapsed_seconds = end - start;
     cout << "Elapsed time: " << elapsed_seconds.count() << " s" << endl;
 
     return true;    // The AI only gives valid moves.
 }
 
+pair<unsigned, unsigned> HexGame::ai_move_calculate(
+    const chrono::steady_clock::time_point start)
+{
+    chrono::steady_clock::time_point deadline
+        = chrono::steady_clock::time_point::max();
+    if (time_budget_ms > 0) {
+        deadline = start + chrono::duration_cast<chrono::steady_clock::duration>(
+            chrono::duration<double, milli>(move_time_budget_get()));
+    }
+
+    pair<unsigned, unsigned> move;
+    if (book && book->probe(board, current_player, move)) {
+        return move;
+    }
+    if (transpositions) {
+        transpositions->generation_next();
+    }
+
+    if (engine == EngineType::UCT) {
+        search.deadline_set(deadline);
+        search.threads_set(nb_threads);
+        search.parallel_set(uct_parallel);
+        move = search.best_move_calculate();
+    } else {
+        MoveEvaluator evaluator(board, current_player, max_simulations,
+                                simulations_per_test_move, nb_threads);
+        if (engine == EngineType::FLAT_MC_HALVING) {
+            evaluator.strategy_set(EvalStrategy::SUCCESSIVE_HALVING);
+        }
+        evaluator.amaf_set(amaf);
+        evaluator.transposition_table_set(transpositions.get());
+        evaluator.deadline_set(deadline);
+        move = evaluator.best_move_calculate();
+    }
+
+    if (time_budget_ms > 0 && time_budget_per_game) {
+        chrono::duration<double, milli> elapsed
+            = chrono::steady_clock::now() - start;
+        double& left = game_time_left_ms[current_player.get() == player_e::O];
+        left = max(left - elapsed.count(), 0.0);
+    }
+    return move;
+}
+
+double HexGame::move_time_budget_get()
+{
+    if (!time_budget_per_game) {
+        return time_budget_ms;
+    }
+    // Split what is left evenly over the moves this player may still have to
+    // play. Games usually end before the board is full, so the budget of the
+    // moves not played is given to the next moves.
+    const unsigned moves_left = (board.unoccupied_list_get().size() + 1) / 2;
+    return game_time_left_ms[current_player.get() == player_e::O]
+        / max(moves_left, 1u);
+}
+
 int HexGame::autoplay_input_move_make(pair<unsigned, unsigned>& move,
                                       double& milliseconds)
 {
-    chrono::time_point<chrono::system_clock> start, end;
-    start = chrono::system_clock::now();
+    // Same clock as the time budget, so that the reported time is the one the
+    // budget was enforced against.
+    chrono::time_point<chrono::steady_clock> start, end;
+    start = chrono::steady_clock::now();
 
-    MoveEvaluator evaluator(board, current_player, max_simulations,
-                            simulations_per_test_move);
-    move = evaluator.best_move_calculate();
+    move = ai_move_calculate(start);
 
-    end = chrono::system_clock::now();
+    end = chrono::steady_clock::now();
     chrono::duration<double, milli> elapsed_milliseconds = end - start;
     milliseconds = elapsed_milliseconds.count();
 
+    // Counters of the search of this move, to the standard error or the trace
+    // file, never to the standard output of the protocol. Nothing unless
+    // compiled with HEX_TRACE.
+    ostringstream label;
+    label << current_player << " col=" << move.first << " row=" << move.second
+          << " ms=" << milliseconds;
+    if (ponder) {
+        label << " pondered=" << nb_pondered;
+    }
+    trace_dump(label.str());
+
     return 0;    // Assume the AI only gives valid moves.
 }
 
+void HexGame::ponder_start()
+{
+    // Without a transposition table, the flat engines would never read the
+    // tree.
+    if (!ponder || ((engine != EngineType::UCT) && !transpositions)) {
+        return;
+    }
+    ponder_stop = false;
+    ponder_thread = thread([this]() {
+        nb_pondered = search.ponder(ponder_stop);
+        // Counted with the next move of the AI.
+        trace_merge();
+    });
+}
+
+void HexGame::ponder_end()
+{
+    if (ponder_thread.joinable()) {
+        ponder_stop = true;
+        ponder_thread.join();
+    }
+}
+
 int HexGame::autoplay_opponent_move_read(pair<unsigned, unsigned>& move,
                                          bool& give_up)
 {
     give_up = false;
-    char column;
-    unsigned col_n, row_n;  // zero-based indeces/
-    char color;
+    string line;
+    if (protocol_in.line_read(line) == ProtocolRead::END) {
+        cerr << "E: end of the input of the opponent" << endl;
+        return -7;
+    }
+
+    // Tokens of the line, blanks skipped.
+    size_t i = 0;
+    const auto next_char_get = [&]() {
+        i = line.find_first_not_of(" \t\r", i);
+        return (i == string::npos) ? '\0' : line[i++];
+    };
 
-    cin >> color;
-    cin >> column; // lower case letter representing board column. May be dot if
-                   // the player wants to quit.
+    const char color = next_char_get();
+    if (color == '\0') {
+        return FLAG_NO_READ; // blank line, nothing read.
+    }
+    // lower case letter representing board column. May be dot if the player
+    // wants to quit.
+    const char column = next_char_get();
     if (color != 'O' && color != 'X') {
         cerr << "E: received illegal color: " << color << endl;
         return -6;
     }
     if (column == ':') {
-        cin.clear();
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
         return FLAG_NO_READ; // return with no error, but a flag that nothing was read.
     }
     if(column == '.') {
         give_up = true;
         return 0;
     }
-    col_n = tolower(column) - 'a';
+    // zero-based index
+    const unsigned col_n = tolower(static_cast<unsigned char>(column)) - 'a';
     if(col_n >= board.size_get()) {
         cerr << color << ": E: " << color <<
             " received illegal column: '" << column << "'\n";
         return -4;
     }
-    cin >> row_n;
-    if(row_n > board.size_get()) {
+    i = line.find_first_not_of(" \t\r", i);
+    unsigned row_n = 0;
+    while ((i != string::npos) && (i < line.size()) && isdigit(line[i])
+           && (row_n <= board.size_get())) {
+        row_n = 10 * row_n + (line[i++] - '0');
+    }
+    if((row_n == 0) || (row_n > board.size_get())) {
         cerr << color << ": E: " << color <<
             " received illegal row: '" << row_n << "'\n";
         return -5;
     }
 
     move = make_pair(col_n, row_n - 1);
-
-    char c = cin.peek();
-    if(c == '.') { // dot at the end of the other player's move
-        // means that he wins, or maybe he gives up - game over
-        return 0;
-    }
-    cin.clear();
-    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    // The rest of the line, e.g. the dot after the winning move of the
+    // other player, or the move count, is ignored.
     return 0;
 }
 
 
 bool HexGame::char_to_player_type_set(const char c, PlayerType& type)
 {
-    if (toupper(c) == 'H') {
+    if (toupper(static_cast<unsigned char>(c)) == 'H') {
         type = PlayerType::HUMAN;
         return true;
-    } else if (toupper(c) == 'A') {
+    } else if (toupper(static_cast<unsigned char>(c)) == 'A') {
         type = PlayerType::AI;
         return true;
     } else {
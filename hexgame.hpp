@@ -4,25 +4,139 @@ Hex game class implementation
 #ifndef HEXGAME_H_INCLUDED
 #define HEXGAME_H_INCLUDED
 
+#include <atomic>
+#include <chrono>
 #include <climits>
 #include <iostream>
+#include <memory>
+#include <thread>
 
 #include "hexboard.hpp"
+#include "openingbook.hpp"
+#include "protocolio.hpp"
+#include "transposition.hpp"
+#include "uctsearch.hpp"
 
 enum class PlayerType { NONE, AI, HUMAN, OPPONENT_AI};
 
+// Search engine of the AI: flat Monte-Carlo (MoveEvaluator), spreading the
+// simulations evenly or by successive halving, or UCT tree search
+// (UctSearch).
+enum class EngineType { FLAT_MC, FLAT_MC_HALVING, UCT };
+
 class HexGame {
 public:
     HexGame(unsigned size, unsigned simulations_per_test_move = 1000,
             unsigned max_simulations = UINT_MAX,
             player_e start_player = player_e::X):
-        board(size), max_simulations(max_simulations),
-        simulations_per_test_move(simulations_per_test_move)
+        board(size),
+        search(board, Player(start_player), max_simulations,
+               simulations_per_test_move),
+        max_simulations(max_simulations),
+        simulations_per_test_move(simulations_per_test_move),
+        nb_threads(1), engine(EngineType::FLAT_MC),
+        uct_parallel(UctParallel::TREE), amaf(false),
+        time_budget_ms(0), time_budget_per_game(false),
+        ponder(false), ponder_stop(false), nb_pondered(0),
+        nb_moves_printed(0)
     {
         current_player.set(start_player);
         winner.set(player_e::NONE);
     }
-    ~HexGame() {}
+    ~HexGame() {
+        ponder_end();
+    }
+
+    // Number of threads the AI may use to evaluate its moves.
+    void threads_set(const unsigned n) {
+        nb_threads = n;
+    }
+
+    void engine_set(const EngineType e) {
+        engine = e;
+    }
+
+    // How the threads share the work of the UCT engine, see
+    // UctSearch::parallel_set().
+    void uct_parallel_set(const UctParallel mode) {
+        uct_parallel = mode;
+    }
+
+    // Blend AMAF statistics into the scores of the flat Monte-Carlo engines,
+    // see MoveEvaluator::amaf_set().
+    void amaf_set(const bool enable) {
+        amaf = enable;
+    }
+
+    // Think for a time budget, in milliseconds, instead of a number of
+    // simulations. The budget is either for every move, or for all the moves
+    // of each AI player in the game. 0 goes back to numbers of simulations.
+    void time_budget_set(const unsigned milliseconds, const bool per_game) {
+        time_budget_ms = milliseconds;
+        time_budget_per_game = per_game;
+        game_time_left_ms[0] = game_time_left_ms[1] = milliseconds;
+    }
+
+    // Policy of the playouts of both engines, see
+    // HexBoard::playout_policy_select().
+    void playout_policy_set(const PlayoutPolicy policy) {
+        board.playout_policy_select(policy);
+        search.playout_policy_set(policy);
+    }
+
+    // Leave the inferior slots (dead, captured) out of the moves searched by
+    // both engines, and pre-fill them in the playouts, see
+    // HexBoard::inferior_slots_use().
+    void inferior_slots_use(const bool enable) {
+        board.inferior_slots_use(enable);
+        search.inferior_slots_use(enable);
+    }
+
+    // In automatic play, search the position with the tree search while
+    // waiting for the move of the opponent (pondering), see
+    // UctSearch::ponder(). The UCT engine goes on from the subtree of the
+    // move played, the flat ones find the statistics of the positions in the
+    // transposition table. Only with the UCT engine or a transposition table,
+    // else there is nothing to ponder for.
+    void ponder_set(const bool enable) {
+        ponder = enable;
+    }
+
+    // Seed the simulations of the AI, before the game starts. With the same
+    // seed and numbers of simulations, the AI plays the same moves, for a
+    // given number of threads with the UCT engine. Time budgets, and the UCT
+    // engine on several threads sharing a tree (UctParallel::TREE), are not
+    // reproducible.
+    void random_seed(const mt19937::result_type seed) {
+        board.random_seed(seed);
+        // The tree search draws its own seed from the board.
+        search = UctSearch(board, current_player, max_simulations,
+                           simulations_per_test_move);
+        search.transposition_table_set(transpositions.get());
+    }
+
+    // Let the engines share their statistics through a transposition table
+    // of that many megabytes, kept for the whole game. 0 for none.
+    void transposition_table_size_set(const size_t megabytes) {
+        if (megabytes == 0) {
+            transpositions.reset();
+        } else {
+            transpositions.reset(new TranspositionTable(megabytes));
+        }
+        search.transposition_table_set(transpositions.get());
+    }
+
+    // Play the moves of an opening book file when the position is in it,
+    // instead of searching. Return false if the file cannot be opened, the
+    // game then has no book.
+    bool opening_book_open(const string& filename) {
+        book.reset(new OpeningBook);
+        if (!book->open(filename)) {
+            book.reset();
+            return false;
+        }
+        return true;
+    }
 
     // ----- Interactive game section -----
     // Show the game introduction header.
@@ -34,14 +148,28 @@ public:
     void winner_print();
 
     // ----- Autoplay section -----
+    // Play the protocol on other descriptors than the standard input and
+    // output, e.g. pipes to another game in the same process (SelfPlayMatch).
+    void autoplay_descriptors_set(const int in_fd, const int out_fd) {
+        protocol_in.descriptor_set(in_fd);
+        protocol_out.descriptor_set(out_fd);
+    }
     int autoplay_handshake(const char color);
     // Set players for autoplay, this AI plays 'color'.
     void player_autoplay_setup(const char color);
     bool autoplay_next_move_play();
 
+    // Player who won, NONE while the game goes on.
+    Player winner_get() const {
+        return winner;
+    }
+
 
 protected:
     HexBoard board;
+    // Persistent tree search, kept in sync with the board by move_play() so
+    // that its statistics carry over from one move to the next.
+    UctSearch search;
     PlayerType player_X_type, player_O_type;
 
     Player current_player;
@@ -49,13 +177,55 @@ protected:
 
     unsigned max_simulations;
     unsigned simulations_per_test_move;
+    unsigned nb_threads;
+    EngineType engine;
+    UctParallel uct_parallel;
+    bool amaf;
+
+    unique_ptr<TranspositionTable> transpositions;
+    unique_ptr<OpeningBook> book;
+
+    unsigned time_budget_ms;
+    bool time_budget_per_game;
+    // Time left in the game for X and O, with a budget per game.
+    double game_time_left_ms[2];
+
+    bool ponder;
+    // Set to stop the pondering thread, checked after each iteration.
+    atomic<bool> ponder_stop;
+    thread ponder_thread;
+    // Iterations of the last pondering, for the trace.
+    unsigned long nb_pondered;
+
+    // Lines of the automatic play protocol, on the standard input and
+    // output.
+    ProtocolReader protocol_in;
+    ProtocolWriter protocol_out;
+    // Moves written by this AI, they are numbered in the protocol.
+    unsigned nb_moves_printed;
+
+    // Start pondering the current position, if enabled, and stop it. The
+    // search and the board must not be used in between.
+    void ponder_start();
+    void ponder_end();
 
     PlayerType current_player_type_get();
 
+    // Play a move for the current player on the board and in the search
+    // tree, return true if it wins.
+    bool move_play(const pair<unsigned, unsigned> move);
+
     void human_prompt_play();
 
     bool human_input_get(pair<unsigned, unsigned>& move);
     bool ai_input_get(pair<unsigned, unsigned>& move);
+    // Move of the opening book for the current position, or else of the
+    // selected engine. start is when the AI started thinking, the time budget
+    // is counted from there.
+    pair<unsigned, unsigned> ai_move_calculate(
+        const chrono::steady_clock::time_point start);
+    // Time budget for the current move, in milliseconds.
+    double move_time_budget_get();
     int autoplay_input_move_make(pair<unsigned, unsigned>& move,
                                  double& milliseconds);
     void autoplay_move_print(pair<unsigned, unsigned> const& move,
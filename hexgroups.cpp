@@ -0,0 +1,149 @@
+/*------------------------------------------------------------------------------
+Incremental connectivity of the stones of a hex board
+hexgroups.cpp
+------------------------------------------------------------------------------*/
+#include <vector>
+
+#include "hexgroups.hpp"
+
+using namespace std;
+
+HexGroups::HexGroups(const unsigned size):
+    size(size),
+    stones(size * size, player_e::NONE),
+    parent(size * size + 4),
+    rank(size * size + 4, 0)
+{
+    for (unsigned i = 0; i < parent.size(); ++i) {
+        parent[i] = i;
+    }
+    // A stone does at most 6 unions (the neighbors, or fewer neighbors and a
+    // side).
+    undo_log.reserve(6 * size * size);
+    undo_start.reserve(size * size);
+    undo_stone.reserve(size * size);
+}
+
+void HexGroups::stone_add(const unsigned col, const unsigned row,
+                          const Player player)
+{
+    stones[row * size + col] = player.get();
+    undo_start.push_back(undo_log.size());
+    undo_stone.push_back(row * size + col);
+    stone_connect(col, row, player.get());
+}
+
+void HexGroups::stone_remove(const unsigned col, const unsigned row)
+{
+    const unsigned lin = row * size + col;
+    stones[lin] = player_e::NONE;
+
+    if (undo_stone.empty() || (undo_stone.back() != lin)) {
+        rebuild();
+        return;
+    }
+
+    // Last stone added, undo its unions in reverse order.
+    for (size_t i = undo_log.size(); i > undo_start.back(); --i) {
+        const UnionUndo& undo = undo_log[i - 1];
+        parent[undo.child] = undo.child;
+        if (undo.rank_increased) {
+            --rank[undo.root];
+        }
+    }
+    undo_log.resize(undo_start.back());
+    undo_start.pop_back();
+    undo_stone.pop_back();
+}
+
+bool HexGroups::win_check(const Player player) const
+{
+    if (player.get() == player_e::X) {
+        return root_find(north_get()) == root_find(south_get());
+    } else {
+        return root_find(west_get()) == root_find(east_get());
+    }
+}
+
+unsigned HexGroups::root_find(unsigned node) const
+{
+    while (parent[node] != node) {
+        node = parent[node];
+    }
+    return node;
+}
+
+void HexGroups::nodes_union(const unsigned a, const unsigned b)
+{
+    unsigned root_a = root_find(a);
+    unsigned root_b = root_find(b);
+    if (root_a == root_b) {
+        return;
+    }
+    if (rank[root_a] > rank[root_b]) {
+        swap(root_a, root_b);
+    }
+    // root_a goes under root_b.
+    parent[root_a] = root_b;
+    bool rank_increased = (rank[root_a] == rank[root_b]);
+    if (rank_increased) {
+        ++rank[root_b];
+    }
+    undo_log.push_back(UnionUndo{root_a, root_b, rank_increased});
+}
+
+void HexGroups::stone_connect(const unsigned col, const unsigned row,
+                              const player_e player)
+{
+    const unsigned lin = row * size + col;
+
+    // The 6 neighbors, see the edges of the board graph in HexBoard.
+    const int neighbors[6][2] = {
+        {-1, 0}, {1, 0}, {0, -1}, {1, -1}, {0, 1}, {-1, 1}
+    };
+    for (auto offset: neighbors) {
+        int c = col + offset[0];
+        int r = row + offset[1];
+        if ((c < 0) || (r < 0)
+            || (c >= static_cast<int>(size)) || (r >= static_cast<int>(size))) {
+            continue;
+        }
+        if (stones[r * size + c] == player) {
+            nodes_union(lin, r * size + c);
+        }
+    }
+
+    if (player == player_e::X) {
+        if (row == 0) {
+            nodes_union(lin, north_get());
+        }
+        if (row == size - 1) {
+            nodes_union(lin, south_get());
+        }
+    } else {
+        if (col == 0) {
+            nodes_union(lin, west_get());
+        }
+        if (col == size - 1) {
+            nodes_union(lin, east_get());
+        }
+    }
+}
+
+void HexGroups::rebuild()
+{
+    for (unsigned i = 0; i < parent.size(); ++i) {
+        parent[i] = i;
+        rank[i] = 0;
+    }
+    for (unsigned lin = 0; lin < stones.size(); ++lin) {
+        if (stones[lin] != player_e::NONE) {
+            stone_connect(lin % size, lin / size, stones[lin]);
+        }
+    }
+
+    // The stones already there cannot be taken back by undo any more.
+    undo_log.clear();
+    undo_start.clear();
+    undo_stone.clear();
+}
@@ -0,0 +1,83 @@
+/*------------------------------------------------------------------------------
+Incremental connectivity of the stones of a hex board
+hexgroups.hpp
+------------------------------------------------------------------------------*/
+#ifndef HEXGROUPS_HPP_INCLUDED
+#define HEXGROUPS_HPP_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include "player.hpp"
+
+// Groups of connected stones, kept up to date as stones are added, with a
+// union-find structure. The nodes are numbered like the vertices of the board
+// graph of HexBoard: row * size + col for the slots, then west, east, north
+// and south for the virtual nodes of the sides. X stones are connected to
+// north and south, O stones to west and east, so a player has won when its two
+// sides are in the same group.
+//
+// Union by rank without path compression, so that each union can be undone:
+// removing the last added stone is cheap. Removing any other stone rebuilds the
+// whole structure.
+class HexGroups {
+public:
+    HexGroups(const unsigned size = 0);
+
+    void stone_add(const unsigned col, const unsigned row, const Player player);
+    void stone_remove(const unsigned col, const unsigned row);
+
+    // Are the two sides of player connected?
+    bool win_check(const Player player) const;
+
+    // Representative node of the group of the slot: two stones are connected
+    // if and only if they have the same group. An empty slot is its own group.
+    unsigned group_get(const unsigned col, const unsigned row) const {
+        return root_find(row * size + col);
+    }
+
+    // Representative node of the group of a side (see west_get() and others).
+    unsigned side_group_get(const unsigned side) const {
+        return root_find(side);
+    }
+
+    unsigned west_get() const { return size * size; }
+    unsigned east_get() const { return size * size + 1; }
+    unsigned north_get() const { return size * size + 2; }
+    unsigned south_get() const { return size * size + 3; }
+
+protected:
+    unsigned size;
+
+    // Owner of each slot.
+    vector<player_e> stones;
+
+    vector<unsigned> parent;
+    vector<uint8_t> rank;
+
+    // A union changes the parent of one root, and maybe the rank of the other.
+    struct UnionUndo {
+        unsigned child;
+        unsigned root;
+        bool rank_increased;
+    };
+    // Unions done by the stones, in order. Stone i did the unions from
+    // undo_start[i] to the next start (or the end of the log).
+    vector<UnionUndo> undo_log;
+    vector<unsigned> undo_start;
+    // Slot of each stone of the log, to check that the stone removed is the
+    // last one added.
+    vector<unsigned> undo_stone;
+
+    unsigned root_find(unsigned node) const;
+    void nodes_union(const unsigned a, const unsigned b);
+
+    // Unions of a new stone with its neighbors and sides.
+    void stone_connect(const unsigned col, const unsigned row,
+                       const player_e player);
+
+    // Start over from the stones, with an empty undo log.
+    void rebuild();
+};
+
+#endif // HEXGROUPS_HPP_INCLUDED
@@ -0,0 +1,188 @@
+/*------------------------------------------------------------------------------
+  hexmatch.cpp
+  Self-play match between two settings of the hexjakt AI, see selfplay.hpp.
+  The games run in this process, several at once, instead of piping hexjakt
+  processes together one game at a time.
+  ------------------------------------------------------------------------------*/
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h> // getopt
+
+#include "hexboard.hpp"
+#include "selfplay.hpp"
+
+using namespace std;
+
+static void usage_print()
+{
+    cout << "Usage:" << endl;
+    cout << "hexmatch [options] size" << endl;
+    cout << "- play games between the AI settings of side A and side B, each"
+         << " side plays X in half of the games" << endl;
+    cout << "    size: size of the board side, 3 to " << hexboard_max_size
+         << endl;
+    cout << endl;
+    cout << "options:" << endl;
+    cout << "    -A settings, -B settings: AI of side A and side B, comma"
+         << " separated (default flat,1000):" << endl;
+    cout << "        flat, halving or uct: the engine, see hexjakt -e." << endl;
+    cout << "        n: n Monte-Carlo iterations per test move." << endl;
+    cout << "        nms: n milliseconds per move, ngms: n milliseconds for"
+         << " all the moves of the game." << endl;
+    cout << "        amaf, bridges, inferior: see hexjakt -a, -p bridges and"
+         << " -i." << endl;
+    cout << "    -n games: number of games (default 100)." << endl;
+    cout << "    -t threads: number of games played at once, 0 for one per"
+         << " core (default 0)." << endl;
+    cout << "    -s seed: seed of the games (default 1)." << endl;
+    cout << "    -v: print the winner of each game." << endl;
+}
+
+// Parse the settings of a side, e.g. "uct,50ms,bridges". Return false if an
+// item is not known.
+static bool side_parse(const string& settings, SelfPlaySide& side)
+{
+    stringstream items(settings);
+    string item;
+    while (getline(items, item, ',')) {
+        if (item == "flat") {
+            side.engine = EngineType::FLAT_MC;
+        } else if (item == "halving") {
+            side.engine = EngineType::FLAT_MC_HALVING;
+        } else if (item == "uct") {
+            side.engine = EngineType::UCT;
+        } else if (item == "amaf") {
+            side.amaf = true;
+        } else if (item == "bridges") {
+            side.playout_policy = PlayoutPolicy::BRIDGES;
+        } else if (item == "inferior") {
+            side.inferior_slots = true;
+        } else if (!item.empty() && isdigit(item[0])) {
+            size_t end;
+            const unsigned n = stoul(item, &end);
+            const string unit = item.substr(end);
+            if (unit.empty()) {
+                side.simulations_per_test_move = n;
+                side.time_budget_ms = 0;
+            } else if ((unit == "ms") || (unit == "gms")) {
+                side.time_budget_ms = n;
+                side.time_budget_per_game = (unit == "gms");
+            } else {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void side_print(const char* name, const string& settings)
+{
+    cout << "    " << name << ": "
+         << (settings.empty() ? "flat,1000" : settings) << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    const SelfPlaySide default_side = {
+        EngineType::FLAT_MC,    // engine
+        1000,                   // simulations_per_test_move
+        0,                      // time_budget_ms
+        false,                  // time_budget_per_game
+        false,                  // amaf
+        PlayoutPolicy::UNIFORM, // playout_policy
+        false                   // inferior_slots
+    };
+    SelfPlaySide side_a = default_side;
+    SelfPlaySide side_b = default_side;
+    string settings_a;
+    string settings_b;
+    unsigned nb_games = 100;
+    unsigned nb_threads = 0;
+    unsigned long seed = 1;
+    bool verbose = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "A:B:n:t:s:v")) != -1) {
+        stringstream ss;
+        if (optarg != nullptr) {
+            ss << optarg;
+        }
+        switch (opt) {
+        case 'A':
+            settings_a = optarg;
+            if (!side_parse(settings_a, side_a)) {
+                usage_print();
+                return -1;
+            }
+            break;
+        case 'B':
+            settings_b = optarg;
+            if (!side_parse(settings_b, side_b)) {
+                usage_print();
+                return -1;
+            }
+            break;
+        case 'n':
+            ss >> nb_games;
+            break;
+        case 't':
+            ss >> nb_threads;
+            break;
+        case 's':
+            ss >> seed;
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        default:
+            usage_print();
+            return -1;
+        }
+    }
+    if (optind != argc - 1) {
+        usage_print();
+        return -1;
+    }
+    const unsigned size = atoi(argv[optind]);
+    if ((size < 3) || (size > hexboard_max_size)) {
+        cerr << "E: board size must be 3 to " << hexboard_max_size << ": "
+             << argv[optind] << endl;
+        return -2;
+    }
+    if (nb_threads == 0) {
+        nb_threads = max(thread::hardware_concurrency(), 1u);
+    }
+
+    SelfPlayMatch match(size, side_a, side_b);
+    match.threads_set(nb_threads);
+    match.seed_set(seed);
+    if (verbose) {
+        match.progress_set(&cout);
+    }
+    const SelfPlayResult result = match.run(nb_games);
+
+    double center, half_width;
+    result.confidence_interval_get(center, half_width);
+    cout << size << "x" << size << ", " << result.nb_games << " games on "
+         << nb_threads << " threads" << endl;
+    side_print("A", settings_a);
+    side_print("B", settings_b);
+    cout << fixed << setprecision(3);
+    cout << "A wins " << result.wins_a << " (" << result.wins_a_as_X
+         << " as X, " << result.wins_a - result.wins_a_as_X << " as O),"
+         << " win rate " << result.win_rate_a_get() << ", 95% interval ["
+         << center - half_width << ", " << center + half_width << "]"
+         << endl;
+    cout << "X wins " << result.wins_X << endl;
+    cout << setprecision(1) << result.seconds << " s, "
+         << result.games_per_hour_get() << " games/hour" << endl;
+    return 0;
+}
@@ -3,61 +3,429 @@ Hex Board Evaluator
 hexboardeval.cpp
 ------------------------------------------------------------------------------*/
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <cstdlib>
+#include <mutex>
+#include <random>
+#include <thread>
 #include <vector>
 #include <utility>
 
 #include "hexboard.hpp"
 #include "moveeval.hpp"
+#include "playoutbatch.hpp"
+#include "trace.hpp"
 
 using namespace std;
 
+// Number of simulations of a test move run in a row, between two checks of
+// the deadline.
+static const unsigned batch_size = 128;
+
+// Number of simulations of a test move at which its own win rate and its AMAF
+// win rate weigh the same in its score, see score_get().
+static const double amaf_equivalence = 1000.0;
+
 pair<unsigned, unsigned> MoveEvaluator::best_move_calculate()
 {
-    const vector< pair<unsigned, unsigned> > free_slots
-                  = board.unoccupied_list_get();
+    tests = board.unoccupied_list_get();
 
     // Limit the number of simulations in regard to the max total number of
     // simulations, and the max number of simulations per test move.
-    unsigned nb_simulations_per_move = max_nb_total_simulations
-            / free_slots.size();
+    nb_simulations_per_move = max_nb_total_simulations / tests.size();
     if (nb_simulations_per_move > max_nb_simulations_per_test) {
         nb_simulations_per_move = max_nb_simulations_per_test;
     }
 
-    board.player_select(tested_player);
+    if (symmetry && board.symmetric_check()) {
+        symmetric_tests_drop();
+    }
 
-    for (auto test_coord: free_slots) {
-        // Play the test move first.
-        bool win = board.play(test_coord, tested_player);
-        if (win) {
-            // No need to run a simulation, this is a best move, winning.
+    // Look for an immediate win first, no need to run any simulation then.
+    {
+        TRACE_TIME(immediate_win_ns);
+        for (auto test_coord: tests) {
+            bool win = board.play(test_coord, tested_player);
             board.unplace(test_coord);
-            return test_coord;
-        }
-        // Save the occupied map including test move, to restore between
-        // simulations.
-        vector<uint16_t> test_occupied = board.occupied_save();
-
-        // Run all the simulations with this test move, keeping track of the
-        // number of times it led to a win (score).
-        int score = 0;
-        for (unsigned mc_run = 0; mc_run < nb_simulations_per_move; ++mc_run) {
-            // Play all positions randomly until the board is full.
-            bool win = board.fill_up_half_and_win_check();
             if (win) {
-                // A full board of hex has always exactly one winner.
-                ++score;
+                TRACE_COUNT(early_exits, 1);
+                best_score = 1.0;
+                best_coord = test_coord;
+                return test_coord;
             }
-            board.occupied_restore(test_occupied);
         }
+    }
+
+    // The inferior slots are never better than the other moves, when the
+    // board uses them. An inferior slot cannot win at once, but the check
+    // above needs no analysis.
+    board.inferior_slots_remove(tests);
+
+    // Master seed of the batches, see batches_simulate(). Drawn from the board
+    // unless given, so that seeding the board makes the whole evaluation
+    // reproducible.
+    base_seed = seeded ? seed : board.random_draw();
 
+    priors_read();
+
+    const unsigned nb_slots = board.size_get() * board.size_get();
+    amaf_wins.assign(amaf ? nb_slots : 0, 0);
+    amaf_playouts.assign(amaf ? nb_slots : 0, 0);
+
+    if ((strategy == EvalStrategy::SUCCESSIVE_HALVING) && (tests.size() > 1)) {
+        successive_halving_run();
+        return best_coord;
+    }
+
+    batches_run();
+
+    TRACE_TIME(selection_ns);
+
+    // Merge in the order of the free slots, ties go to the first one like for
+    // a sequential evaluation. With a deadline, the test moves may not have
+    // the same number of simulations, compare win rates.
+    nb_simulations_run = 0;
+    for (unsigned i = 0; i < tests.size(); ++i) {
+        nb_simulations_run += simulations[i];
+        if (simulations[i] == 0) {
+            continue;
+        }
+        TRACE_COUNT(candidates, 1);
+        transposition_write(i, wins[i], simulations[i]);
+        double score = priors.empty() ?
+            score_get(tests[i], wins[i], simulations[i]) :
+            score_get(tests[i], wins[i] + priors[i].wins,
+                      simulations[i] + priors[i].simulations);
         if (score > best_score) {
             best_score = score;
-            best_coord = test_coord;
+            best_coord = tests[i];
         }
-        board.unplace(test_coord);
     }
 
     return best_coord;
 }
+
+void MoveEvaluator::batches_run()
+{
+    TRACE_TIME(simulations_ns);
+    wins.assign(tests.size(), 0);
+    simulations.assign(tests.size(), 0);
+    next_batch = 0;
+
+    unsigned nb_workers = min<size_t>(max(nb_threads, 1u), tests.size());
+    vector<thread> workers;
+    // The calling thread is one of the workers.
+    for (unsigned i = 1; i < nb_workers; ++i) {
+        workers.push_back(thread(&MoveEvaluator::batches_simulate, this));
+    }
+    batches_simulate();
+    for (auto& worker: workers) {
+        worker.join();
+    }
+}
+
+// Each round gives the same share of the total to the test moves left, which
+// are then ranked on all their simulations so far. With n test moves, there
+// are ceil(log2(n)) rounds, and the best test move gets about
+// total / log2(n) / 2 simulations in the last round alone, against total / n
+// for UNIFORM. With a deadline, each round gets the same share of the time
+// left, and the rounds stop when there is none.
+void MoveEvaluator::successive_halving_run()
+{
+    const vector< pair<unsigned, unsigned> > candidates = tests;
+    const unsigned long total = static_cast<unsigned long>(
+        nb_simulations_per_move) * candidates.size();
+    const chrono::steady_clock::time_point final_deadline = deadline;
+    const bool timed = (deadline != chrono::steady_clock::time_point::max());
+    const mt19937::result_type first_seed = base_seed;
+
+    unsigned nb_rounds = 0;
+    for (size_t n = candidates.size(); n > 1; n = (n + 1) / 2) {
+        ++nb_rounds;
+    }
+
+    // Indexes in candidates of the test moves left, and their results.
+    vector<unsigned> left(candidates.size());
+    for (unsigned i = 0; i < left.size(); ++i) {
+        left[i] = i;
+    }
+    vector<unsigned long> total_wins(candidates.size(), 0);
+    vector<unsigned long> total_simulations(candidates.size(), 0);
+
+    for (unsigned round = 0; left.size() > 1; ++round) {
+        tests.clear();
+        for (auto i: left) {
+            tests.push_back(candidates[i]);
+        }
+        nb_simulations_per_move = max<unsigned long>(
+            total / (nb_rounds * left.size()), 1);
+        if (timed) {
+            const chrono::steady_clock::time_point now
+                = chrono::steady_clock::now();
+            deadline = (final_deadline > now) ?
+                now + (final_deadline - now) / (nb_rounds - round) : now;
+        }
+        // Rounds must not replay the random sequences of the previous ones.
+        seed_seq seq{first_seed, static_cast<mt19937::result_type>(round)};
+        seq.generate(&base_seed, &base_seed + 1);
+
+        batches_run();
+
+        TRACE_TIME(selection_ns);
+        for (unsigned j = 0; j < left.size(); ++j) {
+            total_wins[left[j]] += wins[j];
+            total_simulations[left[j]] += simulations[j];
+        }
+        TRACE_COUNT(candidates, left.size());
+        // Stable, so that ties go to the first free slot as with UNIFORM. The
+        // test moves the deadline left without simulations come last.
+        vector<double> scores(candidates.size(), -1.0);
+        for (auto i: left) {
+            if (total_simulations[i] > 0) {
+                scores[i] = priors.empty() ?
+                    score_get(candidates[i], total_wins[i],
+                              total_simulations[i]) :
+                    score_get(candidates[i], total_wins[i] + priors[i].wins,
+                              total_simulations[i] + priors[i].simulations);
+            }
+        }
+        stable_sort(left.begin(), left.end(), [&](unsigned a, unsigned b) {
+            return scores[a] > scores[b];
+        });
+        if (timed && (chrono::steady_clock::now() >= final_deadline)) {
+            // No time for the next rounds, the best so far is left[0].
+            break;
+        }
+        left.resize((left.size() + 1) / 2);
+    }
+
+    tests = candidates;
+    deadline = final_deadline;
+    base_seed = first_seed;
+    nb_simulations_run = 0;
+    for (unsigned i = 0; i < candidates.size(); ++i) {
+        nb_simulations_run += total_simulations[i];
+        transposition_write(i, total_wins[i], total_simulations[i]);
+    }
+    const unsigned best = left[0];
+    best_coord = candidates[best];
+    best_score = priors.empty() ?
+        score_get(best_coord, total_wins[best], total_simulations[best]) :
+        score_get(best_coord, total_wins[best] + priors[best].wins,
+                  total_simulations[best] + priors[best].simulations);
+}
+
+void MoveEvaluator::symmetric_tests_drop()
+{
+    const unsigned size = board.size_get();
+    vector<bool> dropped(size * size, false);
+    unsigned nb_kept = 0;
+    for (auto test_coord: tests) {
+        if (dropped[test_coord.second * size + test_coord.first]) {
+            continue;
+        }
+        const pair<unsigned, unsigned> rotated = board.rotated_get(test_coord);
+        dropped[rotated.second * size + rotated.first] = true;
+        tests[nb_kept++] = test_coord;
+    }
+    tests.resize(nb_kept);
+}
+
+void MoveEvaluator::priors_read()
+{
+    priors.clear();
+    if (transpositions == nullptr) {
+        return;
+    }
+    priors.assign(tests.size(), TranspositionStats{0, 0});
+    for (unsigned i = 0; i < tests.size(); ++i) {
+        transpositions->probe(board.canonical_hash_after_get(tests[i],
+                                                             tested_player),
+                              priors[i]);
+    }
+}
+
+void MoveEvaluator::transposition_write(const unsigned i,
+                                        const unsigned long nb_wins,
+                                        const unsigned long nb_simulations)
+{
+    if ((transpositions == nullptr) || (nb_simulations == 0)) {
+        return;
+    }
+    transpositions->update(board.canonical_hash_after_get(tests[i],
+                                                          tested_player),
+                           min<unsigned long>(nb_wins, UINT32_MAX),
+                           min<unsigned long>(nb_simulations, UINT32_MAX));
+}
+
+// The weight of the AMAF win rate, sqrt(k / (3 n + k)) with n the simulations
+// of the test move and k amaf_equivalence, is the one of Gelly and Silver's
+// RAVE: AMAF is biased, but has many more samples, which matters most while n
+// is small.
+double MoveEvaluator::score_get(const pair<unsigned, unsigned> test_coord,
+                                const unsigned long nb_wins,
+                                const unsigned long nb_simulations) const
+{
+    const double rate = static_cast<double>(nb_wins) / nb_simulations;
+    if (!amaf) {
+        return rate;
+    }
+    const unsigned lin = test_coord.second * board.size_get() + test_coord.first;
+    if (amaf_playouts[lin] == 0) {
+        return rate;
+    }
+    const double amaf_rate = static_cast<double>(amaf_wins[lin])
+        / amaf_playouts[lin];
+    const double beta = sqrt(amaf_equivalence
+                             / (3.0 * nb_simulations + amaf_equivalence));
+    return beta * amaf_rate + (1.0 - beta) * rate;
+}
+
+void MoveEvaluator::batches_simulate()
+{
+    const bool timed = (deadline != chrono::steady_clock::time_point::max());
+    vector<unsigned long> local_wins(tests.size(), 0);
+    vector<unsigned long> local_simulations(tests.size(), 0);
+    const unsigned size = board.size_get();
+    const bool batched = PlayoutBatch::size_supported(size);
+    PlayoutBatch playouts(size);
+
+    // AMAF statistics of this worker, see amaf_set(). The slots filled by the
+    // playouts of the current PlayoutBatch wait for their results in
+    // amaf_pending, nb_stones per playout.
+    vector<unsigned long> local_amaf_wins(amaf_wins.size(), 0);
+    vector<unsigned long> local_amaf_playouts(amaf_playouts.size(), 0);
+    vector<unsigned> amaf_pending;
+    amaf_pending.reserve(amaf ? PlayoutBatch::max_nb_boards * size * size : 0);
+
+    // The board of this worker: it shares the graph with the original board,
+    // but has its own stones and random engine. Each batch puts it back in
+    // the position of the original board, so that its playouts do not depend
+    // on the batches run before by this worker.
+    HexBoard worker_board(board);
+    worker_board.player_select(tested_player);
+    bool test_placed = false;
+    pair<unsigned, unsigned> test_coord;
+
+    for (;;) {
+        const unsigned long batch = next_batch++;
+        const unsigned i = batch % tests.size();
+        const unsigned long round = batch / tests.size();
+
+        unsigned nb_simulations = batch_size;
+        if (timed) {
+            // The first batch always runs, so that there is a best move.
+            if ((batch > 0) && (chrono::steady_clock::now() >= deadline)) {
+                TRACE_COUNT(deadline_stops, 1);
+                break;
+            }
+        } else {
+            if (round * batch_size >= nb_simulations_per_move) {
+                break;
+            }
+            nb_simulations = min<unsigned long>(
+                batch_size, nb_simulations_per_move - round * batch_size);
+        }
+
+        // The stones of the playouts are already off, see occupied_restore()
+        // below.
+        if (test_placed) {
+            worker_board.unplace(test_coord);
+        }
+        worker_board.unoccupied_order_copy(board);
+        test_coord = tests[i];
+
+        seed_seq seq{base_seed, static_cast<mt19937::result_type>(batch),
+                     static_cast<mt19937::result_type>(batch >> 32)};
+        mt19937::result_type batch_seed;
+        seq.generate(&batch_seed, &batch_seed + 1);
+        worker_board.random_seed(batch_seed);
+
+        // Play the test move first. Immediate wins were already handled.
+        worker_board.place(test_coord, tested_player);
+        test_placed = true;
+        // Save the occupied map including test move, to restore between
+        // simulations.
+        worker_board.occupied_save();
+
+        // Run the simulations with this test move, keeping track of the
+        // number of times it led to a win (score).
+        unsigned score = 0;
+        const vector< pair<unsigned, unsigned> >& free_slots
+            = worker_board.unoccupied_list_get();
+        const unsigned nb_stones = worker_board.playout_nb_stones_get();
+        if (batched) {
+            // Same simulations, but the wins are checked by PlayoutBatch, a
+            // batch of boards at once.
+            for (unsigned mc_run = 0; mc_run < nb_simulations; ++mc_run) {
+                worker_board.fill_up_half();
+                if (amaf) {
+                    for (unsigned k = 0; k < nb_stones; ++k) {
+                        const unsigned lin = free_slots[k].second * size
+                            + free_slots[k].first;
+                        ++local_amaf_playouts[lin];
+                        amaf_pending.push_back(lin);
+                    }
+                }
+                playouts.board_add(worker_board);
+                worker_board.occupied_restore();
+                if ((playouts.nb_boards_get() == PlayoutBatch::max_nb_boards)
+                    || (mc_run == nb_simulations - 1)) {
+                    uint32_t batch_wins = playouts.win_check();
+                    score += __builtin_popcount(batch_wins);
+                    for (unsigned k = 0; amaf && (batch_wins != 0);
+                         ++k, batch_wins >>= 1) {
+                        if (batch_wins & 1) {
+                            for (unsigned j = k * nb_stones;
+                                 j < (k + 1) * nb_stones; ++j) {
+                                ++local_amaf_wins[amaf_pending[j]];
+                            }
+                        }
+                    }
+                    amaf_pending.clear();
+                }
+            }
+        } else {
+            for (unsigned mc_run = 0; mc_run < nb_simulations; ++mc_run) {
+                // Play all positions randomly until the board is full.
+                bool win = worker_board.fill_up_half_and_win_check();
+                if (win) {
+                    // A full board of hex has always exactly one winner.
+                    ++score;
+                }
+                if (amaf) {
+                    for (unsigned k = 0; k < nb_stones; ++k) {
+                        const unsigned lin = free_slots[k].second * size
+                            + free_slots[k].first;
+                        ++local_amaf_playouts[lin];
+                        local_amaf_wins[lin] += win;
+                    }
+                }
+                worker_board.occupied_restore();
+            }
+        }
+        local_wins[i] += score;
+        local_simulations[i] += nb_simulations;
+        if (amaf) {
+            // The test move is the first move of all these playouts.
+            const unsigned lin = test_coord.second * size + test_coord.first;
+            local_amaf_wins[lin] += score;
+            local_amaf_playouts[lin] += nb_simulations;
+        }
+    }
+
+    lock_guard<mutex> lock(merge_mutex);
+    for (unsigned i = 0; i < tests.size(); ++i) {
+        wins[i] += local_wins[i];
+        simulations[i] += local_simulations[i];
+    }
+    for (unsigned lin = 0; lin < amaf_wins.size(); ++lin) {
+        amaf_wins[lin] += local_amaf_wins[lin];
+        amaf_playouts[lin] += local_amaf_playouts[lin];
+    }
+    // The counters of the worker threads go with them.
+    trace_merge();
+}
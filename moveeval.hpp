@@ -5,9 +5,23 @@ moveeval.hpp
 #ifndef MOVEEVAL_H_INCLUDED
 #define MOVEEVAL_H_INCLUDED
 
+#include <atomic>
+#include <chrono>
 #include <climits>
+#include <mutex>
+#include <random>
+#include <utility>
+#include <vector>
 
 #include "hexboard.hpp"
+#include "transposition.hpp"
+
+// How MoveEvaluator spreads the simulations over the test moves:
+// - UNIFORM: the same number for all of them.
+// - SUCCESSIVE_HALVING: in rounds, each one dropping the worse half of the
+//   test moves, until one is left. Most of the simulations go to the best
+//   moves, for the same total.
+enum class EvalStrategy { UNIFORM, SUCCESSIVE_HALVING };
 
 class MoveEvaluator {
 public:
@@ -18,24 +32,103 @@ public:
     // simulations per move).
     // max_nb_simulations_per_test: max number of Monte-Carlo to run per test
     // move.
+    // nb_threads: number of worker threads running the simulations.
     MoveEvaluator(HexBoard& base_board,
                   const Player current_player,
                   const unsigned max_nb_simulations = 100000u,
-                  const unsigned max_nb_simulations_per_test = 2000u):
+                  const unsigned max_nb_simulations_per_test = 2000u,
+                  const unsigned nb_threads = 1u):
         board(base_board),
         tested_player(current_player),
         max_nb_total_simulations(max_nb_simulations),
         max_nb_simulations_per_test(max_nb_simulations_per_test),
-        best_score(-1)
+        nb_threads(nb_threads),
+        strategy(EvalStrategy::UNIFORM),
+        amaf(false),
+        symmetry(true),
+        transpositions(nullptr),
+        seeded(false),
+        seed(0),
+        nb_simulations_run(0),
+        deadline(chrono::steady_clock::time_point::max()),
+        best_score(-1.0)
     {
         // Init to nonsense value.
         best_coord = make_pair(base_board.size_get(), base_board.size_get());
     }
 
+    // Same, but the simulations derive their random sequences from seed
+    // instead of drawing from the random engine of base_board. The results
+    // then depend only on the position and seed, for any number of threads.
+    MoveEvaluator(HexBoard& base_board,
+                  const Player current_player,
+                  const unsigned max_nb_simulations,
+                  const unsigned max_nb_simulations_per_test,
+                  const unsigned nb_threads,
+                  const mt19937::result_type seed):
+        MoveEvaluator(base_board, current_player, max_nb_simulations,
+                      max_nb_simulations_per_test, nb_threads)
+    {
+        seeded = true;
+        this->seed = seed;
+    }
+
     // Play a number of possible moves, evaluate them, and return the best.
     // return value: the coordinate of the best move found.
     pair<unsigned, unsigned> best_move_calculate();
 
+    // The total number of simulations is the same for all the strategies:
+    // that of UNIFORM, or the deadline. With SUCCESSIVE_HALVING, a test move
+    // may get more than max_nb_simulations_per_test.
+    void strategy_set(const EvalStrategy s) {
+        strategy = s;
+    }
+
+    // Also count, for every slot, the playouts where the tested player filled
+    // it, and those of them that won (all moves as first, AMAF). The score of
+    // a test move blends in its AMAF win rate, that gets the information of
+    // about half the playouts of all the other test moves. The blend goes
+    // from AMAF to the test move's own win rate as its simulations add up.
+    void amaf_set(const bool enable) {
+        amaf = enable;
+    }
+
+    // In a symmetric position (see HexBoard::symmetric_check()), e.g. the
+    // empty board, a test move and its rotation are worth the same: only the
+    // first one is evaluated. The test moves left get the same number of
+    // simulations as without the pruning, in about half the time. On by
+    // default.
+    void symmetry_set(const bool enable) {
+        symmetry = enable;
+    }
+
+    // Share the statistics of the test moves through a transposition table:
+    // those already in the table count in the scores, the new ones are added
+    // to it. nullptr, the default, for none.
+    void transposition_table_set(TranspositionTable* table) {
+        transpositions = table;
+    }
+
+    // Run simulations until the deadline instead of a fixed number of them.
+    // The simulations run in batches, the deadline is checked before each
+    // batch but the very first one. The test moves still without
+    // simulations at the deadline are not evaluated.
+    void deadline_set(const chrono::steady_clock::time_point t) {
+        deadline = t;
+    }
+
+    // Score of the move returned by the last call to best_move_calculate(),
+    // its win rate blended as configured, 1 for an immediate win.
+    double best_score_get() const {
+        return best_score;
+    }
+
+    // Number of Monte-Carlo simulations run by the last call to
+    // best_move_calculate().
+    unsigned long nb_simulations_get() const {
+        return nb_simulations_run;
+    }
+
 protected:
     HexBoard& board;
 
@@ -48,11 +141,81 @@ protected:
 
     unsigned max_nb_simulations_per_test;
 
-    int best_score;
+    unsigned nb_threads;
+
+    EvalStrategy strategy;
+    bool amaf;
+    bool symmetry;
+    TranspositionTable* transpositions;
+
+    // Master seed of the simulations, if given to the constructor.
+    bool seeded;
+    mt19937::result_type seed;
+
+    unsigned long nb_simulations_run;
+
+    chrono::steady_clock::time_point deadline;
+
+    // Win rate of the best move.
+    double best_score;
     pair<unsigned, unsigned> best_coord;
     // Store the quality (double) of each test move (unsigned, the node number
     // of the position under test).
     //unordered_map<unsigned, double> quality_map;
+
+    // Work shared by the threads during best_move_calculate(). A batch is a
+    // number of simulations of one test move. Batch n is for test move
+    // n % tests.size(), so that all test moves get a batch before any gets a
+    // second one.
+    vector< pair<unsigned, unsigned> > tests;
+    unsigned nb_simulations_per_move;
+    mt19937::result_type base_seed;
+    atomic<unsigned long> next_batch;
+    // Wins and simulations per test move, merged from the threads.
+    vector<unsigned long> wins;
+    vector<unsigned long> simulations;
+    // Statistics of the test moves found in the transposition table, before
+    // the simulations. Empty without a table.
+    vector<TranspositionStats> priors;
+    // AMAF wins and playouts per slot, indexed by row * size + col, over all
+    // the batches of best_move_calculate().
+    vector<unsigned long> amaf_wins;
+    vector<unsigned long> amaf_playouts;
+    mutex merge_mutex;
+
+    // Score of a test move, from its wins and simulations, and the AMAF
+    // statistics if enabled. The priors must be added by the caller.
+    double score_get(const pair<unsigned, unsigned> test_coord,
+                     const unsigned long nb_wins,
+                     const unsigned long nb_simulations) const;
+
+    // Run nb_simulations_per_move simulations of each move of tests, or until
+    // the deadline, on nb_threads threads. The results are in wins and
+    // simulations.
+    void batches_run();
+
+    // Drop from tests the rotations of the test moves before them, see
+    // symmetry_set().
+    void symmetric_tests_drop();
+
+    // Read the priors of tests from the transposition table, if any.
+    void priors_read();
+    // Add the statistics of test move i, without its prior, to the
+    // transposition table, if any.
+    void transposition_write(const unsigned i, const unsigned long nb_wins,
+                             const unsigned long nb_simulations);
+
+    // Successive halving over tests, see EvalStrategy. Sets best_coord and
+    // best_score.
+    void successive_halving_run();
+
+    // Run the batches picked from next_batch until there are no more, or the
+    // deadline is reached. Each batch runs on a fresh copy of the board, with
+    // its own random sequence derived from base_seed and the batch number,
+    // which makes the results independent of the number of threads and of
+    // their scheduling. On boards of 16 rows or less, the wins are checked
+    // with PlayoutBatch, with the same results.
+    void batches_simulate();
 };
 
 #endif // MOVEEVAL_H_INCLUDED
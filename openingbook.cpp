@@ -0,0 +1,234 @@
+/*------------------------------------------------------------------------------
+Opening book: moves of the first positions of the games, searched offline
+openingbook.cpp
+------------------------------------------------------------------------------*/
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "moveeval.hpp"
+#include "openingbook.hpp"
+
+using namespace std;
+
+// Start of a book file. The entries follow, 8 byte aligned.
+struct OpeningBookHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t nb_entries;
+};
+
+static const char book_magic[8] = {'H', 'E', 'X', 'B', 'O', 'O', 'K', '\0'};
+static const uint32_t book_version = 1;
+
+OpeningBook::OpeningBook():
+    mapping(nullptr), mapping_size(0), entries(nullptr), nb_entries(0)
+{
+}
+
+OpeningBook::~OpeningBook()
+{
+    close();
+}
+
+bool OpeningBook::open(const string& filename)
+{
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat file_stat;
+    if ((fstat(fd, &file_stat) < 0)
+        || (static_cast<size_t>(file_stat.st_size)
+            < sizeof(OpeningBookHeader))) {
+        ::close(fd);
+        return false;
+    }
+    const size_t size = file_stat.st_size;
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid once the file is closed.
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    const OpeningBookHeader* header
+        = static_cast<const OpeningBookHeader*>(map);
+    if ((memcmp(header->magic, book_magic, sizeof(book_magic)) != 0)
+        || (header->version != book_version)
+        || (size != sizeof(OpeningBookHeader)
+            + header->nb_entries * sizeof(OpeningBookEntry))) {
+        munmap(map, size);
+        return false;
+    }
+
+    mapping = map;
+    mapping_size = size;
+    nb_entries = header->nb_entries;
+    entries = reinterpret_cast<const OpeningBookEntry*>(header + 1);
+    return true;
+}
+
+void OpeningBook::close()
+{
+    if (mapping != nullptr) {
+        munmap(mapping, mapping_size);
+    }
+    mapping = nullptr;
+    mapping_size = 0;
+    entries = nullptr;
+    nb_entries = 0;
+}
+
+bool OpeningBook::probe(const HexBoard& board, const Player to_move,
+                        pair<unsigned, unsigned>& move,
+                        double* win_rate) const
+{
+    const uint64_t key = board.canonical_hash_get(to_move);
+    const OpeningBookEntry* end = entries + nb_entries;
+    const OpeningBookEntry* entry = lower_bound(
+        entries, end, key,
+        [](const OpeningBookEntry& e, const uint64_t k) { return e.key < k; });
+    if ((entry == end) || (entry->key != key)) {
+        return false;
+    }
+
+    // A hash collision with a position of another size or book would give
+    // any slot.
+    const unsigned size = board.size_get();
+    if (entry->move >= size * size) {
+        return false;
+    }
+    const pair<unsigned, unsigned> canonical(entry->move % size,
+                                             entry->move / size);
+    // The rotation is its own inverse.
+    const pair<unsigned, unsigned> coord = board.canonical_move_get(canonical);
+    if (board.occupied_check(coord.first, coord.second)) {
+        return false;
+    }
+    move = coord;
+    if (win_rate != nullptr) {
+        *win_rate = entry->win_rate / 65535.0;
+    }
+    return true;
+}
+
+bool OpeningBook::write(const string& filename,
+                        vector<OpeningBookEntry> entries)
+{
+    sort(entries.begin(), entries.end(),
+         [](const OpeningBookEntry& a, const OpeningBookEntry& b) {
+             return a.key < b.key;
+         });
+
+    OpeningBookHeader header;
+    memcpy(header.magic, book_magic, sizeof(book_magic));
+    header.version = book_version;
+    header.nb_entries = entries.size();
+
+    ofstream file(filename, ios::binary | ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()),
+               entries.size() * sizeof(OpeningBookEntry));
+    file.close();
+    return !file.fail();
+}
+
+void OpeningBookGenerator::size_add(const unsigned size)
+{
+    const Player player_X(player_e::X);
+    const Player player_O(player_e::O);
+    HexBoard board(size, seed);
+    expanded.clear();
+    position_expand(board, player_X, player_X);
+    expanded.clear();
+    position_expand(board, player_X, player_O);
+}
+
+vector<OpeningBookEntry> OpeningBookGenerator::entries_get() const
+{
+    vector<OpeningBookEntry> all;
+    for (const auto& entry: entries) {
+        all.push_back(entry.second);
+    }
+    return all;
+}
+
+void OpeningBookGenerator::position_expand(HexBoard& board,
+                                           const Player to_move,
+                                           const Player book_player)
+{
+    const unsigned nb_stones = board.size_get() * board.size_get()
+        - board.unoccupied_list_get().size();
+    if ((nb_stones >= nb_moves)
+        || !expanded.insert(board.canonical_hash_get(to_move)).second) {
+        return;
+    }
+
+    Player next = to_move;
+    next.swap();
+    if (to_move.get() == book_player.get()) {
+        const pair<unsigned, unsigned> move = book_move_get(board, to_move);
+        if (!board.play(move, to_move)) {
+            position_expand(board, next, book_player);
+        }
+        board.unplace(move);
+        return;
+    }
+
+    // Any move of the opponent. The list changes as stones are placed and
+    // removed, iterate on a copy.
+    const vector< pair<unsigned, unsigned> > free_slots
+        = board.unoccupied_list_get();
+    for (auto move: free_slots) {
+        if (!board.play(move, to_move)) {
+            position_expand(board, next, book_player);
+        }
+        board.unplace(move);
+    }
+}
+
+pair<unsigned, unsigned> OpeningBookGenerator::book_move_get(
+    HexBoard& board, const Player to_move)
+{
+    const uint64_t key = board.canonical_hash_get(to_move);
+    const unsigned size = board.size_get();
+    auto found = entries.find(key);
+    if (found != entries.end()) {
+        return board.canonical_move_get(make_pair(found->second.move % size,
+                                                  found->second.move / size));
+    }
+
+    // Each position has its own seed, so that the book does not depend on the
+    // order of the searches.
+    MoveEvaluator evaluator(board, to_move, UINT_MAX, simulations_per_test,
+                            nb_threads,
+                            seed ^ static_cast<mt19937::result_type>(
+                                key ^ (key >> 32)));
+    const pair<unsigned, unsigned> move = evaluator.best_move_calculate();
+    const double win_rate = max(evaluator.best_score_get(), 0.0);
+
+    const pair<unsigned, unsigned> canonical = board.canonical_move_get(move);
+    OpeningBookEntry entry;
+    entry.key = key;
+    entry.simulations = min<unsigned long>(evaluator.nb_simulations_get(),
+                                           UINT32_MAX);
+    entry.move = canonical.second * size + canonical.first;
+    entry.win_rate = static_cast<uint16_t>(win_rate * 65535.0 + 0.5);
+    entries[key] = entry;
+
+    if (progress != nullptr) {
+        *progress << size << "x" << size << " " << entries.size() << ": "
+                  << to_move << " " << static_cast<char>('a' + move.first)
+                  << move.second + 1 << " " << win_rate << endl;
+    }
+    return move;
+}
@@ -0,0 +1,125 @@
+/*------------------------------------------------------------------------------
+Opening book: moves of the first positions of the games, searched offline
+openingbook.hpp
+------------------------------------------------------------------------------*/
+#ifndef OPENINGBOOK_HPP_INCLUDED
+#define OPENINGBOOK_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hexboard.hpp"
+#include "player.hpp"
+
+// A position of the book and its move. The key is
+// HexBoard::canonical_hash_get() with the player to move, which includes the
+// board size: one book holds all the sizes. The move is on the canonical form
+// of the board, see HexBoard::canonical_move_get().
+struct OpeningBookEntry {
+    uint64_t key;
+    // Simulations run to find the move.
+    uint32_t simulations;
+    // row * size + col.
+    uint16_t move;
+    // Win rate of the move, in 1/65535.
+    uint16_t win_rate;
+};
+
+// Read-only book, mapped from a file. The file is a header followed by the
+// entries sorted by key, in the byte order of the machine that wrote it.
+// Probing is a binary search in the mapping: nothing is read from the file
+// but the pages it touches.
+class OpeningBook {
+public:
+    OpeningBook();
+    ~OpeningBook();
+
+    // The mapping cannot be shared.
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    // Map a book file, closing the previous one. Return false if the file
+    // cannot be mapped, or is not a book.
+    bool open(const string& filename);
+    void close();
+
+    // Move of the book for to_move on board, mapped back from the canonical
+    // form, and its win rate. Return false if the position is not in the
+    // book.
+    bool probe(const HexBoard& board, const Player to_move,
+               pair<unsigned, unsigned>& move,
+               double* win_rate = nullptr) const;
+
+    size_t nb_entries_get() const {
+        return nb_entries;
+    }
+
+    // Write entries as a book file. Return false on errors.
+    static bool write(const string& filename,
+                      vector<OpeningBookEntry> entries);
+
+protected:
+    void* mapping;
+    size_t mapping_size;
+    const OpeningBookEntry* entries;
+    size_t nb_entries;
+};
+
+// Offline generation of the book, by deep MoveEvaluator searches. For each
+// player, the book covers the positions of the first nb_moves moves of the
+// game where that player is to move, after their own previous moves were
+// those of the book, and after any move of the opponent.
+class OpeningBookGenerator {
+public:
+    OpeningBookGenerator(const unsigned nb_moves,
+                         const unsigned simulations_per_test,
+                         const unsigned nb_threads,
+                         const mt19937::result_type seed):
+        nb_moves(nb_moves),
+        simulations_per_test(simulations_per_test),
+        nb_threads(nb_threads),
+        seed(seed),
+        progress(nullptr)
+    {}
+
+    // Report each search on os, nullptr for none.
+    void progress_set(ostream* os) {
+        progress = os;
+    }
+
+    // Search the positions of that board size, and add them to the book.
+    void size_add(const unsigned size);
+
+    // Entries of all the sizes added, sorted by key.
+    vector<OpeningBookEntry> entries_get() const;
+
+protected:
+    unsigned nb_moves;
+    unsigned simulations_per_test;
+    unsigned nb_threads;
+    mt19937::result_type seed;
+    ostream* progress;
+
+    map<uint64_t, OpeningBookEntry> entries;
+    // Canonical hashes of the positions already expanded.
+    set<uint64_t> expanded;
+
+    // Add the positions reachable from board, with to_move to play, and
+    // book_player playing the moves of the book.
+    void position_expand(HexBoard& board, const Player to_move,
+                         const Player book_player);
+
+    // Move of the book for to_move on board, searched if not in the book
+    // yet.
+    pair<unsigned, unsigned> book_move_get(HexBoard& board,
+                                           const Player to_move);
+};
+
+#endif // OPENINGBOOK_HPP_INCLUDED
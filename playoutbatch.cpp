@@ -0,0 +1,287 @@
+/*------------------------------------------------------------------------------
+Win detection for a batch of playouts at once
+playoutbatch.cpp
+------------------------------------------------------------------------------*/
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PLAYOUTBATCH_X86
+#endif
+
+#include "hexboard.hpp"
+#include "playoutbatch.hpp"
+#include "trace.hpp"
+
+using namespace std;
+
+const unsigned PlayoutBatch::max_nb_boards;
+
+// All the kernels comb the boards the same way, until nothing changes any more
+// in any board of the batch: a sweep from the first row downwards (5 and 7
+// o'clock), then one upwards (11 and 1 o'clock), each followed by a lateral
+// spread on the row (3 and 9 o'clock). Unlike HexBoard::win_check(), which
+// follows the stones of a single board, the work is the same for all the
+// boards, which is what lockstep needs. The lateral spread is done in log
+// steps: stretches of 1, 2, 4 then 8 stones.
+
+static uint32_t win_check_scalar(uint16_t rows[][PlayoutBatch::max_nb_boards],
+                                 const unsigned size);
+#ifdef PLAYOUTBATCH_X86
+static uint32_t win_check_sse2(uint16_t rows[][PlayoutBatch::max_nb_boards],
+                               const unsigned size);
+static uint32_t win_check_avx2(uint16_t rows[][PlayoutBatch::max_nb_boards],
+                               const unsigned size);
+#endif
+
+PlayoutBatch::PlayoutBatch(const unsigned size):
+    size(size), nb_boards(0), kernel(kernel_best())
+{
+    for (unsigned i = 0; i < 16; ++i) {
+        for (unsigned b = 0; b < max_nb_boards; ++b) {
+            rows[i][b] = 0;
+        }
+    }
+}
+
+PlayoutBatch::Kernel PlayoutBatch::kernel_best()
+{
+#ifdef PLAYOUTBATCH_X86
+    if (__builtin_cpu_supports("avx2")) {
+        return Kernel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return Kernel::SSE2;
+    }
+#endif
+    return Kernel::SCALAR;
+}
+
+const char* PlayoutBatch::kernel_name(const Kernel kernel)
+{
+    switch (kernel) {
+    case Kernel::AVX2:
+        return "avx2";
+    case Kernel::SSE2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+void PlayoutBatch::board_add(const HexBoard& board)
+{
+    const uint16_t* board_rows = board.playout_rows_get();
+    for (unsigned i = 0; i < size; ++i) {
+        rows[i][nb_boards] = board_rows[i];
+    }
+    ++nb_boards;
+}
+
+uint32_t PlayoutBatch::win_check()
+{
+    // The lockstep kernels do not comb step by step, only the win checks are
+    // counted.
+    TRACE_COUNT(win_checks, nb_boards);
+    TRACE_TIME(win_check_ns);
+    uint32_t wins;
+    switch (kernel) {
+#ifdef PLAYOUTBATCH_X86
+    case Kernel::AVX2:
+        wins = win_check_avx2(rows, size);
+        break;
+    case Kernel::SSE2:
+        wins = win_check_sse2(rows, size);
+        break;
+#endif
+    default:
+        wins = win_check_scalar(rows, size);
+        break;
+    }
+
+    // The boards after nb_boards hold whatever was left by previous batches.
+    wins &= (uint32_t(1) << nb_boards) - 1;
+    nb_boards = 0;
+    return wins;
+}
+
+static inline uint16_t spread_scalar(uint16_t combed, uint16_t occupied)
+{
+    uint16_t left = occupied;
+    uint16_t right = occupied;
+    for (unsigned shift = 1; shift < 16; shift *= 2) {
+        combed |= (left & (combed << shift)) | (right & (combed >> shift));
+        left &= left << shift;
+        right &= right >> shift;
+    }
+    return combed;
+}
+
+static uint32_t win_check_scalar(uint16_t rows[][PlayoutBatch::max_nb_boards],
+                                 const unsigned size)
+{
+    uint32_t wins = 0;
+    for (unsigned b = 0; b < PlayoutBatch::max_nb_boards; ++b) {
+        uint16_t combed[16] = {0};
+        combed[0] = rows[0][b];
+        bool changed;
+        do {
+            changed = false;
+            for (unsigned i = 1; i < size; ++i) {
+                uint16_t c = rows[i][b]
+                    & (combed[i] | combed[i - 1] | (combed[i - 1] >> 1));
+                c = spread_scalar(c, rows[i][b]);
+                changed |= (c != combed[i]);
+                combed[i] = c;
+            }
+            for (unsigned i = size - 1; i-- > 0; ) {
+                uint16_t c = rows[i][b]
+                    & (combed[i] | combed[i + 1] | (combed[i + 1] << 1));
+                c = spread_scalar(c, rows[i][b]);
+                changed |= (c != combed[i]);
+                combed[i] = c;
+            }
+        } while (changed);
+
+        if (combed[size - 1] != 0) {
+            wins |= uint32_t(1) << b;
+        }
+    }
+    return wins;
+}
+
+#ifdef PLAYOUTBATCH_X86
+
+__attribute__((target("sse2")))
+static inline __m128i spread_sse2(__m128i combed, const __m128i occupied)
+{
+    __m128i left = occupied;
+    __m128i right = occupied;
+    for (int shift = 1; shift < 16; shift *= 2) {
+        combed = _mm_or_si128(
+            combed,
+            _mm_or_si128(_mm_and_si128(left, _mm_slli_epi16(combed, shift)),
+                         _mm_and_si128(right, _mm_srli_epi16(combed, shift))));
+        left = _mm_and_si128(left, _mm_slli_epi16(left, shift));
+        right = _mm_and_si128(right, _mm_srli_epi16(right, shift));
+    }
+    return combed;
+}
+
+// 8 boards per register, the batch is done in two halves.
+__attribute__((target("sse2")))
+static uint32_t win_check_sse2(uint16_t rows[][PlayoutBatch::max_nb_boards],
+                               const unsigned size)
+{
+    uint32_t wins = 0;
+    for (unsigned half = 0; half < PlayoutBatch::max_nb_boards; half += 8) {
+        __m128i occupied[16];
+        __m128i combed[16];
+        for (unsigned i = 0; i < size; ++i) {
+            occupied[i] = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(&rows[i][half]));
+            combed[i] = _mm_setzero_si128();
+        }
+        combed[0] = occupied[0];
+
+        __m128i changed;
+        do {
+            changed = _mm_setzero_si128();
+            for (unsigned i = 1; i < size; ++i) {
+                __m128i c = _mm_or_si128(
+                    combed[i],
+                    _mm_or_si128(combed[i - 1],
+                                 _mm_srli_epi16(combed[i - 1], 1)));
+                c = spread_sse2(_mm_and_si128(c, occupied[i]), occupied[i]);
+                changed = _mm_or_si128(changed, _mm_xor_si128(c, combed[i]));
+                combed[i] = c;
+            }
+            for (unsigned i = size - 1; i-- > 0; ) {
+                __m128i c = _mm_or_si128(
+                    combed[i],
+                    _mm_or_si128(combed[i + 1],
+                                 _mm_slli_epi16(combed[i + 1], 1)));
+                c = spread_sse2(_mm_and_si128(c, occupied[i]), occupied[i]);
+                changed = _mm_or_si128(changed, _mm_xor_si128(c, combed[i]));
+                combed[i] = c;
+            }
+        } while (_mm_movemask_epi8(
+                     _mm_cmpeq_epi8(changed, _mm_setzero_si128())) != 0xffff);
+
+        uint16_t last[8];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(last), combed[size - 1]);
+        for (unsigned b = 0; b < 8; ++b) {
+            if (last[b] != 0) {
+                wins |= uint32_t(1) << (half + b);
+            }
+        }
+    }
+    return wins;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i spread_avx2(__m256i combed, const __m256i occupied)
+{
+    __m256i left = occupied;
+    __m256i right = occupied;
+    for (int shift = 1; shift < 16; shift *= 2) {
+        combed = _mm256_or_si256(
+            combed,
+            _mm256_or_si256(
+                _mm256_and_si256(left, _mm256_slli_epi16(combed, shift)),
+                _mm256_and_si256(right, _mm256_srli_epi16(combed, shift))));
+        left = _mm256_and_si256(left, _mm256_slli_epi16(left, shift));
+        right = _mm256_and_si256(right, _mm256_srli_epi16(right, shift));
+    }
+    return combed;
+}
+
+// The whole batch in one register.
+__attribute__((target("avx2")))
+static uint32_t win_check_avx2(uint16_t rows[][PlayoutBatch::max_nb_boards],
+                               const unsigned size)
+{
+    __m256i occupied[16];
+    __m256i combed[16];
+    for (unsigned i = 0; i < size; ++i) {
+        occupied[i] = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(&rows[i][0]));
+        combed[i] = _mm256_setzero_si256();
+    }
+    combed[0] = occupied[0];
+
+    __m256i changed;
+    do {
+        changed = _mm256_setzero_si256();
+        for (unsigned i = 1; i < size; ++i) {
+            __m256i c = _mm256_or_si256(
+                combed[i],
+                _mm256_or_si256(combed[i - 1],
+                                _mm256_srli_epi16(combed[i - 1], 1)));
+            c = spread_avx2(_mm256_and_si256(c, occupied[i]), occupied[i]);
+            changed = _mm256_or_si256(changed, _mm256_xor_si256(c, combed[i]));
+            combed[i] = c;
+        }
+        for (unsigned i = size - 1; i-- > 0; ) {
+            __m256i c = _mm256_or_si256(
+                combed[i],
+                _mm256_or_si256(combed[i + 1],
+                                _mm256_slli_epi16(combed[i + 1], 1)));
+            c = spread_avx2(_mm256_and_si256(c, occupied[i]), occupied[i]);
+            changed = _mm256_or_si256(changed, _mm256_xor_si256(c, combed[i]));
+            combed[i] = c;
+        }
+    } while (!_mm256_testz_si256(changed, changed));
+
+    uint16_t last[16];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(last), combed[size - 1]);
+    uint32_t wins = 0;
+    for (unsigned b = 0; b < 16; ++b) {
+        if (last[b] != 0) {
+            wins |= uint32_t(1) << b;
+        }
+    }
+    return wins;
+}
+
+#endif // PLAYOUTBATCH_X86
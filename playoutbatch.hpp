@@ -0,0 +1,65 @@
+/*------------------------------------------------------------------------------
+Win detection for a batch of playouts at once
+playoutbatch.hpp
+------------------------------------------------------------------------------*/
+#ifndef PLAYOUTBATCH_HPP_INCLUDED
+#define PLAYOUTBATCH_HPP_INCLUDED
+
+#include <cstdint>
+
+#include "hexboard.hpp"
+
+// Filled up boards are collected into a batch, then checked for a win all at
+// once. Row i of all the boards is combed in lockstep, one SIMD lane per board:
+// 16 boards per AVX2 register, 8 per SSE2 register. The kernel is chosen at
+// run time from the instructions the CPU has, with a plain scalar one as a
+// fallback.
+//
+// Only boards of 16 rows or less, whose rows are 16 bit words, are batched
+// (see size_supported()).
+class PlayoutBatch {
+public:
+    static const unsigned max_nb_boards = 16;
+
+    enum class Kernel { SCALAR, SSE2, AVX2 };
+
+    PlayoutBatch(const unsigned size);
+
+    static bool size_supported(const unsigned size) {
+        return size <= 16;
+    }
+
+    // Best kernel for this CPU.
+    static Kernel kernel_best();
+    static const char* kernel_name(const Kernel kernel);
+
+    // Use another kernel than the best one, e.g. to compare them. It must be
+    // supported by the CPU.
+    void kernel_set(const Kernel k) {
+        kernel = k;
+    }
+
+    // Add the bitboard of the current player of the board (see
+    // HexBoard::player_select()), typically just filled up by
+    // HexBoard::fill_up_half(). At most max_nb_boards.
+    void board_add(const HexBoard& board);
+
+    unsigned nb_boards_get() const {
+        return nb_boards;
+    }
+
+    // Check all the boards of the batch for a win of their player, and empty
+    // the batch. Bit i of the result is set if board i won.
+    uint32_t win_check();
+
+protected:
+    unsigned size;
+    unsigned nb_boards;
+    Kernel kernel;
+
+    // Row-major: rows[i][b] is row i of board b. The unused boards are empty,
+    // and never win.
+    uint16_t rows[16][max_nb_boards];
+};
+
+#endif // PLAYOUTBATCH_HPP_INCLUDED
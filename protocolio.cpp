@@ -0,0 +1,176 @@
+/*------------------------------------------------------------------------------
+Protocol I/O: buffered lines of the automatic play protocol on file descriptors
+protocolio.cpp
+------------------------------------------------------------------------------*/
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <poll.h>
+#include <unistd.h>
+
+#include "protocolio.hpp"
+
+using namespace std;
+
+// Initial size of the read buffer, it grows for longer lines.
+static const size_t reader_buffer_size = 4096;
+
+ProtocolReader::ProtocolReader(const int fd):
+    fd(fd), buffer(reader_buffer_size), begin(0), end(0), closed(false)
+{
+}
+
+void ProtocolReader::descriptor_set(const int new_fd)
+{
+    fd = new_fd;
+    begin = end = 0;
+    closed = false;
+}
+
+ProtocolRead ProtocolReader::line_read(string& line, const int timeout_ms)
+{
+    const chrono::steady_clock::time_point deadline
+        = chrono::steady_clock::now() + chrono::milliseconds(timeout_ms);
+    int wait_ms = timeout_ms;
+
+    while (!line_cut(line)) {
+        if (closed) {
+            if (begin == end) {
+                return ProtocolRead::END;
+            }
+            line.assign(&buffer[begin], end - begin);
+            begin = end = 0;
+            return ProtocolRead::LINE;
+        }
+        if (!buffer_fill(wait_ms)) {
+            return ProtocolRead::TIMEOUT;
+        }
+        if (timeout_ms >= 0) {
+            // What is left of the timeout, for the rest of the line.
+            const auto left = chrono::duration_cast<chrono::milliseconds>(
+                deadline - chrono::steady_clock::now()).count();
+            wait_ms = (left > 0) ? left : 0;
+        }
+    }
+    return ProtocolRead::LINE;
+}
+
+bool ProtocolReader::line_cut(string& line)
+{
+    const char* start = &buffer[begin];
+    const char* newline
+        = static_cast<const char*>(memchr(start, '\n', end - begin));
+    if (newline == nullptr) {
+        return false;
+    }
+    line.assign(start, newline - start);
+    begin += newline - start + 1;
+    if (begin == end) {
+        begin = end = 0;
+    }
+    return true;
+}
+
+bool ProtocolReader::buffer_fill(const int timeout_ms)
+{
+    // Room at the end of the buffer: move the partial line to the front, or
+    // grow the buffer if it is all one line.
+    if (end == buffer.size()) {
+        if (begin > 0) {
+            memmove(&buffer[0], &buffer[begin], end - begin);
+            end -= begin;
+            begin = 0;
+        } else {
+            buffer.resize(2 * buffer.size());
+        }
+    }
+
+    struct pollfd input;
+    input.fd = fd;
+    input.events = POLLIN;
+    int ready;
+    do {
+        ready = poll(&input, 1, timeout_ms);
+    } while ((ready < 0) && (errno == EINTR));
+    if (ready == 0) {
+        return false;
+    }
+    if (ready < 0) {
+        closed = true;
+        return true;
+    }
+
+    ssize_t nb_read;
+    do {
+        nb_read = read(fd, &buffer[end], buffer.size() - end);
+    } while ((nb_read < 0) && (errno == EINTR));
+    if (nb_read > 0) {
+        end += nb_read;
+    } else if ((nb_read == 0) || (errno != EAGAIN)) {
+        // End of the input, or an error: nothing more will come.
+        closed = true;
+    }
+    return true;
+}
+
+ProtocolWriter::ProtocolWriter(const int fd): fd(fd)
+{
+}
+
+void ProtocolWriter::descriptor_set(const int new_fd)
+{
+    fd = new_fd;
+    buffer.clear();
+}
+
+ProtocolWriter& ProtocolWriter::operator<<(const char* text)
+{
+    buffer += text;
+    return *this;
+}
+
+ProtocolWriter& ProtocolWriter::operator<<(const char c)
+{
+    buffer += c;
+    return *this;
+}
+
+ProtocolWriter& ProtocolWriter::operator<<(unsigned n)
+{
+    char digits[16];
+    unsigned nb_digits = 0;
+    do {
+        digits[nb_digits++] = '0' + n % 10;
+        n /= 10;
+    } while (n != 0);
+    while (nb_digits > 0) {
+        buffer += digits[--nb_digits];
+    }
+    return *this;
+}
+
+ProtocolWriter& ProtocolWriter::operator<<(const Player& player)
+{
+    buffer += (player.get() == player_e::X) ? 'X' : 'O';
+    return *this;
+}
+
+bool ProtocolWriter::flush()
+{
+    size_t written = 0;
+    while (written < buffer.size()) {
+        const ssize_t n = write(fd, buffer.data() + written,
+                                buffer.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            buffer.clear();
+            return false;
+        }
+        written += n;
+    }
+    buffer.clear();
+    return true;
+}
@@ -0,0 +1,71 @@
+/*------------------------------------------------------------------------------
+Protocol I/O: buffered lines of the automatic play protocol on file descriptors
+protocolio.hpp
+------------------------------------------------------------------------------*/
+#ifndef PROTOCOLIO_HPP_INCLUDED
+#define PROTOCOLIO_HPP_INCLUDED
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "player.hpp"
+
+// Outcome of ProtocolReader::line_read().
+enum class ProtocolRead { LINE, TIMEOUT, END };
+
+// Reader of the lines of the opponent, without iostreams. Whatever the
+// descriptor has is read at once into a buffer, and the lines are cut from
+// it. The descriptor is only waited on with poll(), for as long as the caller
+// allows, so that a caller never hangs in the middle of a partial line.
+class ProtocolReader {
+public:
+    explicit ProtocolReader(const int fd = 0);
+
+    // Read from another descriptor, dropping what is buffered.
+    void descriptor_set(const int fd);
+
+    // Next line, without its '\n'. Wait at most timeout_ms milliseconds for
+    // it, or forever if negative. The last line may miss its '\n'. END once
+    // the input is closed and the buffer empty, or on read errors.
+    ProtocolRead line_read(std::string& line, const int timeout_ms = -1);
+
+protected:
+    int fd;
+    std::vector<char> buffer;
+    // Bytes not handed out yet: [begin, end) of the buffer.
+    size_t begin;
+    size_t end;
+    bool closed;
+
+    // Cut the next line out of the buffer, return false if none is complete.
+    bool line_cut(std::string& line);
+    // Wait for input, then append what is there to the buffer. Return false
+    // on timeout.
+    bool buffer_fill(const int timeout_ms);
+};
+
+// Writer of the lines of this player, without iostreams. Everything is
+// buffered until flush(): a move is one write() to the descriptor.
+class ProtocolWriter {
+public:
+    explicit ProtocolWriter(const int fd = 1);
+
+    void descriptor_set(const int fd);
+
+    ProtocolWriter& operator<<(const char* text);
+    ProtocolWriter& operator<<(const char c);
+    ProtocolWriter& operator<<(unsigned n);
+    // "X" or "O".
+    ProtocolWriter& operator<<(const Player& player);
+
+    // Write the buffer out, return false on errors. The buffer is emptied
+    // either way.
+    bool flush();
+
+protected:
+    int fd;
+    std::string buffer;
+};
+
+#endif // PROTOCOLIO_HPP_INCLUDED
@@ -0,0 +1,121 @@
+/*------------------------------------------------------------------------------
+Small random engines for the simulations
+random.hpp
+------------------------------------------------------------------------------*/
+#ifndef RANDOM_HPP_INCLUDED
+#define RANDOM_HPP_INCLUDED
+
+#include <cstdint>
+#include <limits>
+
+// The engines below meet the requirements of UniformRandomBitGenerator, like
+// mt19937, so that they can be used with the standard library as well. They
+// pass the usual statistical test suites (BigCrush, PractRand), and have a
+// state of a few words, against 2.5 kB for mt19937.
+
+// PCG32 (XSH RR variant), by M. E. O'Neill: a 64 bit LCG whose output is
+// permuted. One multiplication per number.
+class Pcg32 {
+public:
+    typedef uint32_t result_type;
+
+    explicit Pcg32(const uint64_t s = 0) {
+        seed(s);
+    }
+
+    void seed(const uint64_t s) {
+        state = 0;
+        (*this)();
+        state += s;
+        (*this)();
+    }
+
+    static constexpr result_type min() {
+        return 0;
+    }
+    static constexpr result_type max() {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()() {
+        uint64_t old_state = state;
+        state = old_state * 6364136223846793005ULL + increment;
+        uint32_t xorshifted = ((old_state >> 18u) ^ old_state) >> 27u;
+        uint32_t rot = old_state >> 59u;
+        return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+    }
+
+private:
+    static const uint64_t increment = 1442695040888963407ULL;
+    uint64_t state;
+};
+
+// xoshiro256**, by D. Blackman and S. Vigna: shifts, rotations and xors on 4
+// words, 64 bit numbers.
+class Xoshiro256 {
+public:
+    typedef uint64_t result_type;
+
+    explicit Xoshiro256(const uint64_t s = 0) {
+        seed(s);
+    }
+
+    // The state is filled with splitmix64, as recommended by the authors, so
+    // that close seeds give unrelated states, and never all zeros.
+    void seed(uint64_t s) {
+        for (auto& word: state) {
+            s += 0x9e3779b97f4a7c15ULL;
+            uint64_t z = s;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    static constexpr result_type min() {
+        return 0;
+    }
+    static constexpr result_type max() {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()() {
+        const uint64_t result = rotl(state[1] * 5, 7) * 9;
+        const uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+private:
+    uint64_t state[4];
+
+    static uint64_t rotl(const uint64_t x, const int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
+// Uniform number in [0, range), for 0 < range < 2^32, with Lemire's multiply
+// and shift method: no division, except to reject the few biased values.
+// Only the 32 high bits of 64 bit engines are used, they are the best ones.
+template <typename Engine>
+inline uint32_t random_below(Engine& engine, const uint32_t range)
+{
+    const int shift = (Engine::max() > 0xffffffffULL) ? 32 : 0;
+    uint64_t m = uint64_t(uint32_t(engine() >> shift)) * range;
+    uint32_t low = uint32_t(m);
+    if (low < range) {
+        const uint32_t threshold = uint32_t(-range) % range;
+        while (low < threshold) {
+            m = uint64_t(uint32_t(engine() >> shift)) * range;
+            low = uint32_t(m);
+        }
+    }
+    return m >> 32;
+}
+
+#endif // RANDOM_HPP_INCLUDED
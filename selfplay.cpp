@@ -0,0 +1,155 @@
+/*------------------------------------------------------------------------------
+Self-play: matches of two AI settings, many games at once in one process
+selfplay.cpp
+------------------------------------------------------------------------------*/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "selfplay.hpp"
+
+using namespace std;
+
+// Normal quantile of the 95% confidence intervals.
+static const double z = 1.96;
+
+double SelfPlayResult::win_rate_a_get() const
+{
+    return (nb_games == 0) ? 0.0 : static_cast<double>(wins_a) / nb_games;
+}
+
+void SelfPlayResult::confidence_interval_get(double& center,
+                                             double& half_width) const
+{
+    if (nb_games == 0) {
+        center = 0.5;
+        half_width = 0.5;
+        return;
+    }
+    // Unlike the normal approximation, the Wilson interval stays within
+    // [0, 1] and is not empty at win rates of 0 or 1.
+    const double n = nb_games;
+    const double p = win_rate_a_get();
+    const double shrink = 1.0 / (1.0 + z * z / n);
+    center = shrink * (p + z * z / (2.0 * n));
+    half_width = shrink * z * sqrt(p * (1.0 - p) / n + z * z / (4.0 * n * n));
+}
+
+double SelfPlayResult::games_per_hour_get() const
+{
+    return (seconds > 0.0) ? nb_games * 3600.0 / seconds : 0.0;
+}
+
+SelfPlayMatch::SelfPlayMatch(const unsigned size, const SelfPlaySide& side_a,
+                             const SelfPlaySide& side_b):
+    size(size), sides{side_a, side_b}, nb_threads(1), seed(1),
+    progress(nullptr)
+{
+}
+
+SelfPlayResult SelfPlayMatch::run(const unsigned nb_games)
+{
+    SelfPlayResult result = {nb_games, 0, 0, 0, 0.0};
+    atomic<unsigned> next_game(0);
+    mutex result_mutex;
+
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    auto worker = [&]() {
+        for (unsigned index = next_game++; index < nb_games;
+             index = next_game++) {
+            const Player winner = game_play(index);
+            const bool a_is_X = (index % 2 == 0);
+            const bool X_wins = (winner.get() == player_e::X);
+            lock_guard<mutex> lock(result_mutex);
+            result.wins_X += X_wins;
+            result.wins_a += (X_wins == a_is_X);
+            result.wins_a_as_X += (X_wins && a_is_X);
+        }
+    };
+    vector<thread> threads;
+    for (unsigned i = 1; i < min(nb_threads, nb_games); ++i) {
+        threads.push_back(thread(worker));
+    }
+    worker();
+    for (auto& t: threads) {
+        t.join();
+    }
+    const chrono::duration<double> elapsed
+        = chrono::steady_clock::now() - start;
+    result.seconds = elapsed.count();
+    return result;
+}
+
+Player SelfPlayMatch::game_play(const unsigned index)
+{
+    // Side of X and of O.
+    const SelfPlaySide& side_X = sides[index % 2];
+    const SelfPlaySide& side_O = sides[1 - index % 2];
+
+    // The moves of X to O, and of O to X.
+    int X_to_O[2];
+    int O_to_X[2];
+    if ((pipe(X_to_O) != 0) || (pipe(O_to_X) != 0)) {
+        cerr << __func__ << ": cannot create the pipes of the game" << endl;
+        exit(-1);
+    }
+
+    HexGame game_X(size, side_X.simulations_per_test_move);
+    HexGame game_O(size, side_O.simulations_per_test_move);
+    side_apply(game_X, side_X, 2 * (seed + index));
+    side_apply(game_O, side_O, 2 * (seed + index) + 1);
+    game_X.autoplay_descriptors_set(O_to_X[0], X_to_O[1]);
+    game_O.autoplay_descriptors_set(X_to_O[0], O_to_X[1]);
+
+    // O first: X waits for the handshake of O, O skips the one of X with the
+    // moves.
+    game_O.autoplay_handshake('O');
+    game_X.autoplay_handshake('X');
+    game_X.player_autoplay_setup('X');
+    game_O.player_autoplay_setup('O');
+
+    // Each move is played by the game of its player, and written to the
+    // other one, which reads it. A move is a few bytes, the pipes never fill
+    // up.
+    HexGame* mover = &game_X;
+    HexGame* reader = &game_O;
+    bool game_over;
+    do {
+        game_over = mover->autoplay_next_move_play();
+        reader->autoplay_next_move_play();
+        swap(mover, reader);
+    } while (!game_over);
+    // The last mover is now the reader.
+    const Player winner = reader->winner_get();
+
+    for (int fd: {X_to_O[0], X_to_O[1], O_to_X[0], O_to_X[1]}) {
+        close(fd);
+    }
+
+    if (progress != nullptr) {
+        lock_guard<mutex> lock(progress_mutex);
+        *progress << "game " << index + 1 << ": " << winner << " ("
+                  << ((winner.get() == player_e::X) == (index % 2 == 0) ?
+                      "A" : "B")
+                  << ") wins" << endl;
+    }
+    return winner;
+}
+
+void SelfPlayMatch::side_apply(HexGame& game, const SelfPlaySide& side,
+                               const unsigned long game_seed)
+{
+    game.engine_set(side.engine);
+    game.amaf_set(side.amaf);
+    game.playout_policy_set(side.playout_policy);
+    game.inferior_slots_use(side.inferior_slots);
+    game.time_budget_set(side.time_budget_ms, side.time_budget_per_game);
+    game.random_seed(game_seed);
+}
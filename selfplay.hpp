@@ -0,0 +1,87 @@
+/*------------------------------------------------------------------------------
+Self-play: matches of two AI settings, many games at once in one process
+selfplay.hpp
+------------------------------------------------------------------------------*/
+#ifndef SELFPLAY_HPP_INCLUDED
+#define SELFPLAY_HPP_INCLUDED
+
+#include <iostream>
+#include <mutex>
+
+#include "hexboard.hpp"
+#include "hexgame.hpp"
+
+// Settings of the AI of one side of a match, see the setters of HexGame.
+struct SelfPlaySide {
+    EngineType engine;
+    unsigned simulations_per_test_move;
+    // Milliseconds per move, or per game, instead of the simulations if not
+    // 0.
+    unsigned time_budget_ms;
+    bool time_budget_per_game;
+    bool amaf;
+    PlayoutPolicy playout_policy;
+    bool inferior_slots;
+};
+
+struct SelfPlayResult {
+    unsigned nb_games;
+    // Games won by side A, in total and as X. Side A plays X in the even
+    // games, i.e. half of the games rounded up.
+    unsigned wins_a;
+    unsigned wins_a_as_X;
+    // Games won by X, whichever side plays it.
+    unsigned wins_X;
+    double seconds;
+
+    // Win rate of side A, and half the width of its 95% confidence interval
+    // (Wilson score interval, centred on center).
+    double win_rate_a_get() const;
+    void confidence_interval_get(double& center, double& half_width) const;
+    double games_per_hour_get() const;
+};
+
+// Match between two settings of the AI, side A and side B. Each game is a
+// pair of HexGame, one per side, playing the automatic play protocol to each
+// other through pipes: autoplay_next_move_play() as between two processes.
+// The games are spread over a pool of threads, each game on a single thread.
+// The colours alternate, and every game has seeds of its own: with budgets in
+// simulations, the results do not depend on the number of threads.
+class SelfPlayMatch {
+public:
+    SelfPlayMatch(const unsigned size, const SelfPlaySide& side_a,
+                  const SelfPlaySide& side_b);
+
+    void threads_set(const unsigned n) {
+        nb_threads = n;
+    }
+
+    // Seeds of the games are drawn from seed and their number.
+    void seed_set(const unsigned long new_seed) {
+        seed = new_seed;
+    }
+
+    // Print a line per game played to out, nullptr for none (default).
+    void progress_set(ostream* out) {
+        progress = out;
+    }
+
+    SelfPlayResult run(const unsigned nb_games);
+
+    // Play game number index, side A is X if index is even. Return the
+    // winner.
+    Player game_play(const unsigned index);
+
+protected:
+    unsigned size;
+    SelfPlaySide sides[2];
+    unsigned nb_threads;
+    unsigned long seed;
+    ostream* progress;
+    mutex progress_mutex;
+
+    void side_apply(HexGame& game, const SelfPlaySide& side,
+                    const unsigned long game_seed);
+};
+
+#endif // SELFPLAY_HPP_INCLUDED
@@ -0,0 +1,267 @@
+/*----------------------------------------------------------------------------
+Unit test for the class AnalysisServer
+----------------------------------------------------------------------------*/
+
+// Module under test
+#include "../analysis.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../protocolio.hpp"
+
+using namespace std;
+
+//******************************************************************************
+// Module variables
+//******************************************************************************
+static const char socket_path[] = "test.socket";
+
+//******************************************************************************
+// Function prototypes
+//******************************************************************************
+void test_analysis_errors();
+void test_analysis_win();
+void test_analysis_columns();
+void test_analysis_positions();
+void test_analysis_uct();
+void test_analysis_serve();
+void test_analysis_socket();
+
+static bool answer_parse(const string& answer, string& move, double& rate);
+
+int main(void)
+{
+    test_analysis_errors();
+    test_analysis_win();
+    test_analysis_columns();
+    test_analysis_positions();
+    test_analysis_uct();
+    test_analysis_serve();
+    test_analysis_socket();
+    cout << endl << "All tested passed." << endl;
+    return 0;
+}
+
+void test_analysis_errors()
+{
+    cout << __func__ << endl;
+    AnalysisServer server;
+    const char* requests[] = {
+        "",
+        "7 X",
+        "2 X 10",
+        "65 X 10",
+        "7 Z 10",
+        "7 X 0",
+        "7 X 10s",
+        "7 X 99999999999",
+        "7 X 10 Xh1",
+        "7 X 10 Xa0",
+        "7 X 10 Xa8",
+        "7 X 10 Xa1x",
+        "7 X 10 Za1",
+        "7 X 10 X",
+        "7 X 10 Xa1 Oa1",
+        "7 X 10 X1",
+        "27 X 10 Xab1",
+        "64 X 10 Xbm1",
+        "64 X 10 Xzzzzzzzzzz1",
+    };
+    for (auto request: requests) {
+        assert(server.request_answer(request)[0] == '?');
+    }
+
+    // A won position.
+    assert(server.request_answer("3 O 10 Xa1 Xa2 Xa3")
+           == "? the game is over");
+}
+
+void test_analysis_win()
+{
+    cout << __func__ << endl;
+    AnalysisServer server;
+    assert(server.request_answer("5 X 10 Xa1 Xa2 Xa3 Xa4 Ob1")
+           == "= a5 1.000");
+    assert(server.request_answer("5 O 10 Xe2 Oa3 Ob3 Oc3 Od3")
+           == "= e3 1.000");
+}
+
+// The columns after z are aa, ab...
+void test_analysis_columns()
+{
+    cout << __func__ << endl;
+    AnalysisServer server;
+    // X wins by filling column ad, the 30th, up to its last row.
+    string request = "30 X 10";
+    for (unsigned row = 1; row < 30; ++row) {
+        request += " Xad" + to_string(row);
+    }
+    assert(server.request_answer(request) == "= ad30 1.000");
+    // Capital letters, and the last column of the largest board.
+    assert(server.request_answer("64 O 10 Obk1 OBL1")[0] == '=');
+    // O wins by filling row 64 up to column bl.
+    request = "64 O 10 Xa1";
+    for (unsigned col = 0; col < 63; ++col) {
+        request += " O";
+        if (col >= 26) {
+            request += static_cast<char>('a' + col / 26 - 1);
+        }
+        request += static_cast<char>('a' + col % 26);
+        request += "64";
+    }
+    assert(server.request_answer(request) == "= bl64 1.000");
+}
+
+// Positions on the same board, stones added, removed and changed between
+// the requests.
+void test_analysis_positions()
+{
+    cout << __func__ << endl;
+    AnalysisServer server;
+    server.random_seed(1);
+
+    assert(server.request_answer("5 X 10 Xa1 Xa2 Xa3 Xa4")
+           == "= a5 1.000");
+    // a3 now O: no immediate win, a3 is not played again.
+    string move;
+    double rate;
+    assert(answer_parse(server.request_answer("5 X 50 Xa1 Xa2 Oa3 Xa4"),
+                        move, rate));
+    assert((move != "a1") && (move != "a2") && (move != "a3")
+           && (move != "a4"));
+    assert((rate > 0.0) && (rate < 1.0));
+    // a1 removed, a5 and b1 added.
+    assert(server.request_answer("5 X 10 Ob1 Xa2 Xa3 Xa4 Xa5")
+           == "= a1 1.000");
+    // Another size meanwhile, then back.
+    assert(server.request_answer("3 O 10 Oa1 Ob1") == "= c1 1.000");
+    assert(server.request_answer("5 O 10 Oa2 Ob2 Oc2 Oe2")
+           == "= d2 1.000");
+    // The empty board.
+    assert(answer_parse(server.request_answer("5 X 20"), move, rate));
+}
+
+// The tree is kept from one request to the next one.
+void test_analysis_uct()
+{
+    cout << __func__ << endl;
+    AnalysisServer server;
+    server.engine_set(EngineType::UCT);
+    server.random_seed(1);
+
+    string move;
+    double rate;
+    assert(answer_parse(server.request_answer("5 X 100"), move, rate));
+    assert((rate > 0.0) && (rate < 1.0));
+    // Same position, then one move later, then another position.
+    assert(answer_parse(server.request_answer("5 X 100"), move, rate));
+    assert(answer_parse(server.request_answer("5 O 100 Xc3"), move, rate));
+    assert(move != "c3");
+    assert(answer_parse(server.request_answer("5 O 100 Xb2"), move, rate));
+    assert(move != "b2");
+    assert(server.request_answer("5 X 100 Xa1 Xa2 Xa3 Xa4")
+           == "= a5 1.000");
+    assert(answer_parse(server.request_answer("5 X 20ms Ob2"), move, rate));
+}
+
+void test_analysis_serve()
+{
+    cout << __func__ << endl;
+    int requests[2];
+    int answers[2];
+    assert((pipe(requests) == 0) && (pipe(answers) == 0));
+    const char input[] = "3 X 10 Xa1 Xa2\n\n  7 Z 10  \nquit\n3 X 10\n";
+    assert(write(requests[1], input, strlen(input))
+           == static_cast<ssize_t>(strlen(input)));
+
+    AnalysisServer server;
+    assert(server.serve(requests[0], answers[1]));
+    close(answers[1]);
+
+    ProtocolReader reader(answers[0]);
+    string line;
+    assert(reader.line_read(line) == ProtocolRead::LINE);
+    assert(line == "= a3 1.000");
+    assert(reader.line_read(line) == ProtocolRead::LINE);
+    assert(line == "? player must be X or O: Z");
+    // Nothing after quit.
+    assert(reader.line_read(line) == ProtocolRead::END);
+
+    // Closed input.
+    close(requests[1]);
+    assert(!server.serve(requests[0], answers[0]));
+    close(requests[0]);
+    close(answers[0]);
+}
+
+void test_analysis_socket()
+{
+    cout << __func__ << endl;
+    AnalysisServer server;
+    assert(!server.socket_serve(string(200, 'x')));
+    // Not a socket: kept as it is.
+    FILE* file = fopen(socket_path, "w");
+    assert(file != nullptr);
+    fclose(file);
+    assert(!server.socket_serve(socket_path));
+    assert(access(socket_path, F_OK) == 0);
+    unlink(socket_path);
+
+    bool served = false;
+    thread server_thread([&]() {
+        served = server.socket_serve(socket_path);
+    });
+
+    // Two clients, one after the other: the second one stops the server.
+    for (unsigned client = 0; client < 2; ++client) {
+        const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        assert(fd >= 0);
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        strcpy(address.sun_path, socket_path);
+        // The server may not listen yet.
+        unsigned nb_tries = 0;
+        while (connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+                       sizeof(address)) < 0) {
+            assert(++nb_tries < 1000);
+            usleep(1000);
+        }
+
+        ProtocolWriter writer(fd);
+        writer << "3 O 10 Oa1 Ob1\n";
+        if (client == 1) {
+            writer << "quit\n";
+        }
+        assert(writer.flush());
+        ProtocolReader reader(fd);
+        string line;
+        assert(reader.line_read(line, 10000) == ProtocolRead::LINE);
+        assert(line == "= c1 1.000");
+        close(fd);
+    }
+    server_thread.join();
+    assert(served);
+    // The socket file is removed.
+    assert(access(socket_path, F_OK) != 0);
+}
+
+// "= move rate", return false for an error.
+static bool answer_parse(const string& answer, string& move, double& rate)
+{
+    char text[8];
+    if (sscanf(answer.c_str(), "= %7s %lf", text, &rate) != 2) {
+        return false;
+    }
+    move = text;
+    return true;
+}
@@ -6,9 +6,11 @@ Unit test for the class HexBoard
 #include "../hexboard.hpp"
 #include "../player.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <iostream>
+#include <random>
 #include <vector>
 
 using namespace std;
@@ -24,9 +26,11 @@ static const Player player_X(player_e::X);
 //******************************************************************************
 void test_hexboard_constructor(void);
 void test_hexboard_copy_constructor(void);
+void test_hexboard_seed_constructor(void);
 void test_hexboard_display(void);
 void test_hexboard_play(void);
 void test_hexboard_unoccupied_list_get();
+void test_hexboard_unoccupied_place_unplace();
 void test_hexboard_occupied_list_get();
 void test_hexboard_fill_up();
 void test_hexboard_win_1(void);
@@ -40,6 +44,50 @@ void test_hexboard_win_8(void);
 void test_hexboard_win_9(void);
 void test_hexboard_unplace(void);
 void test_hexboard_occupied_save_restore();
+void test_hexboard_unoccupied_order_copy();
+// A copy playing and undoing moves and playouts, put back in the order of
+// the original: the same seed gives the same playout again.
+void test_hexboard_unoccupied_order_copy()
+{
+    cout << __func__ << endl;
+    HexBoard board(7);
+    board.play(3, 3, player_X);
+    HexBoard copy(board);
+    copy.player_select(player_O);
+
+    vector< vector<unsigned> > playouts;
+    for (unsigned n = 0; n < 2; ++n) {
+        copy.unoccupied_order_copy(board);
+        assert(copy.unoccupied_list_get() == board.unoccupied_list_get());
+        copy.random_seed(5);
+        copy.place(2, 4, player_O);
+        copy.occupied_save();
+        copy.fill_up_half();
+        vector<unsigned> filled;
+        for (unsigned k = 0; k < copy.playout_nb_stones_get(); ++k) {
+            const pair<unsigned, unsigned> slot
+                = copy.unoccupied_list_get()[k];
+            filled.push_back(slot.second * 7 + slot.first);
+        }
+        playouts.push_back(filled);
+        // Other playouts meanwhile.
+        copy.occupied_restore();
+        copy.fill_up_half();
+        copy.occupied_restore();
+        copy.unplace(2, 4);
+    }
+    assert(playouts[0] == playouts[1]);
+}
+
+void test_hexboard_wide_rows();
+void test_hexboard_groups_track();
+void test_hexboard_fill_up_half_engines();
+void test_hexboard_hash();
+void test_hexboard_symmetry();
+void test_hexboard_bridges();
+void test_hexboard_inferior_patterns();
+void test_hexboard_inferior_sound();
+void test_hexboard_inferior_playouts();
 
 int main(void)
 {
@@ -47,9 +95,11 @@ int main(void)
 
     test_hexboard_constructor();
     test_hexboard_copy_constructor();
+    test_hexboard_seed_constructor();
     test_hexboard_display();
     test_hexboard_play();
     test_hexboard_unoccupied_list_get();
+    test_hexboard_unoccupied_place_unplace();
     test_hexboard_occupied_list_get();
     test_hexboard_fill_up();
     test_hexboard_win_1();
@@ -63,6 +113,16 @@ int main(void)
     test_hexboard_win_9();
     test_hexboard_unplace();
     test_hexboard_occupied_save_restore();
+    test_hexboard_unoccupied_order_copy();
+    test_hexboard_wide_rows();
+    test_hexboard_groups_track();
+    test_hexboard_fill_up_half_engines();
+    test_hexboard_hash();
+    test_hexboard_symmetry();
+    test_hexboard_bridges();
+    test_hexboard_inferior_patterns();
+    test_hexboard_inferior_sound();
+    test_hexboard_inferior_playouts();
     cout << "All tested passed (but user check needed!)." << endl;
     return 0;
 }
@@ -84,6 +144,17 @@ void test_hexboard_copy_constructor(void)
     assert(win);
 }
 
+void test_hexboard_seed_constructor(void)
+{
+    cout << __func__ << endl;
+    HexBoard board(5, 7);
+    HexBoard same_seed(5, 7);
+    HexBoard other_seed(5, 8);
+
+    assert(board.random_draw() == same_seed.random_draw());
+    assert(board.random_draw() != other_seed.random_draw());
+}
+
 void test_hexboard_display(void)
 {
     cout << __func__ << endl;
@@ -130,6 +201,44 @@ void test_hexboard_unoccupied_list_get()
     }
 }
 
+void test_hexboard_unoccupied_place_unplace()
+{
+    cout << __func__ << endl;
+    const unsigned size = 7;
+    HexBoard board(size);
+    board.random_seed(1);
+
+    // Place and remove stones in random order, with shuffles in between, and
+    // check that the list always holds exactly the free slots.
+    for (unsigned i = 0; i < 2000; ++i) {
+        unsigned col = rand() % size;
+        unsigned row = rand() % size;
+        if (board.occupied_check(col, row)) {
+            board.unplace(col, row);
+        } else {
+            board.place(col, row, (i % 2 == 0) ? player_X : player_O);
+        }
+        if (i % 100 == 0) {
+            board.player_select(player_X);
+            board.occupied_save();
+            board.fill_up_half_and_win_check();
+            board.occupied_restore();
+        }
+
+        const vector< pair<unsigned, unsigned> >& free_list
+            = board.unoccupied_list_get();
+        vector<bool> listed(size * size, false);
+        for (auto coord: free_list) {
+            assert(!board.occupied_check(coord.first, coord.second));
+            assert(!listed[coord.second * size + coord.first]);
+            listed[coord.second * size + coord.first] = true;
+        }
+        for (unsigned lin = 0; lin < size * size; ++lin) {
+            assert(listed[lin] != board.occupied_check(lin % size, lin / size));
+        }
+    }
+}
+
 void test_hexboard_occupied_list_get()
 {
     cout << __func__ << endl;
@@ -423,12 +532,474 @@ void test_hexboard_occupied_save_restore()
     board.play(0, 2, player_O);
     board.play(1, 1, player_O);
 
-    vector<uint16_t> occupied_O_backup = board.occupied_save(player_O);
+    board.player_select(player_O);
+    board.occupied_save();
     board.play(2, 0, player_O);
     assert(board.win_check(player_O));
 
-    board.occupied_restore(player_O, occupied_O_backup);
+    board.occupied_restore();
     assert(!board.win_check(player_O));
     board.play(2, 1, player_O);
     assert(board.win_check(player_O));
 }
+
+void test_hexboard_wide_rows()
+{
+    cout << __func__ << endl;
+    // One size per width of bitboard rows, with the last column and row
+    // using the highest bit.
+    const unsigned sizes[] = {16, 17, 32, 33, 64};
+    for (unsigned size: sizes) {
+        HexBoard board(size);
+        assert(board.sanity_check());
+
+        // X goes down the last column, O along the last row.
+        for (unsigned i = 0; i < size - 1; ++i) {
+            assert(!board.play(size - 1, i, player_X));
+            assert(!board.play(i, size - 1, player_O));
+        }
+        assert(board.play(size - 1, size - 1, player_X));
+        assert(!board.win_check(player_O));
+        board.unplace(size - 1, size - 1);
+        assert(!board.win_check(player_X));
+        assert(board.play(size - 1, size - 1, player_O));
+    }
+}
+
+void test_hexboard_groups_track()
+{
+    cout << __func__ << endl;
+
+    // Random games, the groups must agree with win_check() after every move,
+    // and after taking back moves.
+    for (unsigned game = 0; game < 50; ++game) {
+        const unsigned size = 2 + game % 10;
+        HexBoard board(size);
+        HexBoard reference(size);
+        board.groups_track(true);
+        Player player(player_e::X);
+
+        while (!board.unoccupied_list_get().empty()) {
+            const vector< pair<unsigned, unsigned> >& free_list
+                = board.unoccupied_list_get();
+            pair<unsigned, unsigned> move = free_list[rand() % free_list.size()];
+            bool win = board.play(move, player);
+            bool reference_win = reference.play(move, player);
+            assert(win == reference_win);
+            if (win) {
+                break;
+            }
+
+            // Sometimes take back this move, or an older one.
+            if (rand() % 4 == 0) {
+                board.unplace(move);
+                reference.unplace(move);
+            } else if (rand() % 8 == 0) {
+                pair<unsigned, unsigned> old_move;
+                do {
+                    old_move = make_pair(rand() % size, rand() % size);
+                } while (!board.occupied_check(old_move.first, old_move.second));
+                board.unplace(old_move);
+                reference.unplace(old_move);
+            }
+            player.swap();
+        }
+    }
+}
+
+void test_hexboard_fill_up_half_engines()
+{
+    cout << __func__ << endl;
+    const unsigned size = 9;
+
+    for (auto engine: {RandomEngine::MT19937, RandomEngine::PCG32,
+                       RandomEngine::XOSHIRO256}) {
+        HexBoard board(size);
+        board.random_engine_select(engine);
+        board.random_seed(42);
+        board.place(4, 4, player_X);
+        board.player_select(player_O);
+        board.occupied_save();
+        HexBoard same_seed(board);
+
+        // Half of the 80 free slots get a stone, never an occupied one, and
+        // all the slots get one at some point.
+        vector<unsigned> nb_stones(size * size, 0);
+        for (unsigned run = 0; run < 1000; ++run) {
+            board.fill_up_half();
+            same_seed.fill_up_half();
+            unsigned count = 0;
+            for (unsigned col = 0; col < size; ++col) {
+                uint16_t column = board.playout_rows_get()[col];
+                assert(column == same_seed.playout_rows_get()[col]);
+                for (unsigned row = 0; row < size; ++row) {
+                    if (column & (1u << row)) {
+                        ++count;
+                        ++nb_stones[row * size + col];
+                    }
+                }
+            }
+            assert(count == 40);
+            board.occupied_restore();
+            same_seed.occupied_restore();
+        }
+        assert(nb_stones[4 * size + 4] == 0);
+        for (unsigned lin = 0; lin < size * size; ++lin) {
+            // About 500 expected for each free slot.
+            assert((lin == 4 * size + 4)
+                   || ((nb_stones[lin] > 400) && (nb_stones[lin] < 600)));
+        }
+        assert(board.unoccupied_list_get().size() == 80);
+    }
+}
+
+void test_hexboard_hash()
+{
+    cout << __func__ << endl;
+    HexBoard board(5);
+    const uint64_t empty_hash = board.hash_get();
+    assert(empty_hash != HexBoard(6).hash_get());
+
+    // Same stones, other order.
+    board.place(1, 2, player_X);
+    board.place(3, 3, player_O);
+    board.place(0, 4, player_X);
+    HexBoard other(5);
+    other.place(0, 4, player_X);
+    other.place(3, 3, player_O);
+    other.place(1, 2, player_X);
+    assert(board.hash_get() == other.hash_get());
+
+    // Same slots, other players.
+    HexBoard swapped(5);
+    swapped.place(1, 2, player_O);
+    swapped.place(3, 3, player_X);
+    swapped.place(0, 4, player_X);
+    assert(board.hash_get() != swapped.hash_get());
+
+    // The player to move.
+    assert(board.hash_get(player_X) == board.hash_get());
+    assert(board.hash_get(player_O) != board.hash_get(player_X));
+
+    // hash_after_get() predicts place().
+    const uint64_t after = board.hash_after_get(make_pair(4, 0), player_O);
+    board.place(4, 0, player_O);
+    assert(after == board.hash_get(player_X));
+
+    // Removing the stones brings the hash back, the playouts do not touch it.
+    board.player_select(player_X);
+    board.occupied_save();
+    const uint64_t before_playout = board.hash_get();
+    board.fill_up_half_and_win_check();
+    board.occupied_restore();
+    assert(board.hash_get() == before_playout);
+    board.unplace(4, 0);
+    board.unplace(1, 2);
+    board.unplace(3, 3);
+    board.unplace(0, 4);
+    assert(board.hash_get() == empty_hash);
+}
+
+void test_hexboard_symmetry()
+{
+    cout << __func__ << endl;
+    // All the bitboard widths.
+    for (unsigned size: {5, 6, 20, 40}) {
+        HexBoard board(size);
+        HexBoard rotated(size);
+        assert(board.symmetric_check());
+        assert(board.rotated_get(make_pair(0, 1))
+               == make_pair(size - 1, size - 2));
+
+        board.place(1, 0, player_X);
+        board.place(0, 2, player_O);
+        rotated.place(board.rotated_get(make_pair(1, 0)), player_X);
+        rotated.place(board.rotated_get(make_pair(0, 2)), player_O);
+        assert(!board.symmetric_check());
+        assert(board.hash_get() != rotated.hash_get());
+        assert(board.canonical_hash_get(player_X)
+               == rotated.canonical_hash_get(player_X));
+        assert(board.canonical_hash_get(player_O)
+               != board.canonical_hash_get(player_X));
+
+        // A move maps to the same slot of the canonical form from both
+        // boards.
+        const pair<unsigned, unsigned> move(2, 3);
+        assert(board.canonical_move_get(move)
+               == rotated.canonical_move_get(rotated.rotated_get(move)));
+        assert(board.canonical_hash_after_get(move, player_X)
+               == rotated.canonical_hash_after_get(rotated.rotated_get(move),
+                                                   player_X));
+        const uint64_t after = board.canonical_hash_after_get(move, player_X);
+        board.place(move, player_X);
+        assert(board.canonical_hash_get(player_O) == after);
+        board.unplace(move);
+
+        // With the rotated stones as well, the board is symmetric.
+        board.place(rotated.rotated_get(make_pair(1, 0)), player_X);
+        assert(!board.symmetric_check());
+        board.place(rotated.rotated_get(make_pair(0, 2)), player_O);
+        assert(board.symmetric_check());
+        assert(board.hash_get() == board.canonical_hash_get(player_X));
+    }
+
+    // The center of an odd board is its own rotation.
+    HexBoard board(7);
+    board.place(3, 3, player_O);
+    assert(board.symmetric_check());
+    board.place(3, 2, player_O);
+    assert(!board.symmetric_check());
+}
+
+// True if slot is one of the stones of the last fill up of board.
+static bool playout_stone_check(const HexBoard& board,
+                                const pair<unsigned, unsigned> slot)
+{
+    const vector< pair<unsigned, unsigned> >& slots
+        = board.unoccupied_list_get();
+    const auto end = slots.begin() + board.playout_nb_stones_get();
+    return find(slots.begin(), end, slot) != end;
+}
+
+void test_hexboard_bridges()
+{
+    cout << __func__ << endl;
+    // The three shapes of bridges, for both players, on all the widths.
+    for (unsigned size: {7, 20, 40}) {
+        HexBoard board(size, 3);
+        // The carriers, one pair per bridge.
+        const pair<unsigned, unsigned> carriers[][2] = {
+            {{2, 2}, {1, 2}},   // X (2, 1) and (1, 3)
+            {{4, 1}, {4, 2}},   // X (5, 1) and (3, 2)
+            {{6, 5}, {5, 6}},   // O (5, 5) and (6, 6)
+        };
+        board.place(2, 1, player_X);
+        board.place(1, 3, player_X);
+        board.place(5, 1, player_X);
+        board.place(3, 2, player_X);
+        board.place(5, 5, player_O);
+        board.place(6, 6, player_O);
+        board.playout_policy_select(PlayoutPolicy::BRIDGES);
+
+        for (Player player: {player_X, player_O}) {
+            board.player_select(player);
+            board.occupied_save();
+            unsigned nb_first[3] = {0, 0, 0};
+            for (unsigned i = 0; i < 200; ++i) {
+                board.fill_up_half_and_win_check();
+                assert(board.playout_nb_stones_get()
+                       == board.unoccupied_list_get().size() / 2);
+                for (unsigned j = 0; j < 3; ++j) {
+                    // Exactly one slot of each carrier was filled.
+                    const bool first
+                        = playout_stone_check(board, carriers[j][0]);
+                    assert(first
+                           != playout_stone_check(board, carriers[j][1]));
+                    nb_first[j] += first;
+                }
+                board.occupied_restore();
+            }
+            // Either slot, at random.
+            for (unsigned j = 0; j < 3; ++j) {
+                assert((nb_first[j] > 50) && (nb_first[j] < 150));
+            }
+        }
+
+        // Uniform playouts give both slots of a carrier to the same player
+        // about half of the time.
+        board.playout_policy_select(PlayoutPolicy::UNIFORM);
+        board.player_select(player_X);
+        board.occupied_save();
+        unsigned nb_same = 0;
+        for (unsigned i = 0; i < 200; ++i) {
+            board.fill_up_half_and_win_check();
+            nb_same += playout_stone_check(board, carriers[0][0])
+                == playout_stone_check(board, carriers[0][1]);
+            board.occupied_restore();
+        }
+        assert((nb_same > 50) && (nb_same < 150));
+        assert(board.sanity_check());
+    }
+}
+
+void test_hexboard_inferior_patterns()
+{
+    cout << __func__ << endl;
+    for (unsigned size: {7, 20, 40}) {
+        HexBoard board(size, 5);
+        // Four neighbours of (3, 3) in a row: east, north-east, north, west.
+        board.place(4, 3, player_X);
+        board.place(4, 2, player_X);
+        board.place(3, 2, player_X);
+        board.place(2, 3, player_X);
+        assert(board.inferior_get(3, 3) == InferiorSlot::DEAD);
+        assert(board.inferior_get(4, 3) == InferiorSlot::NONE);
+        assert(board.inferior_get(1, 5) == InferiorSlot::NONE);
+
+        // Three in a row are not enough.
+        board.unplace(2, 3);
+        assert(board.inferior_get(3, 3) == InferiorSlot::NONE);
+
+        // The sides count as stones: the west side belongs to O, and with
+        // (0, 2) and (0, 4), four neighbours of (0, 3) in a row are of O.
+        board.place(0, 2, player_O);
+        assert(board.inferior_get(0, 3) == InferiorSlot::NONE);
+        board.place(0, 4, player_O);
+        assert(board.inferior_get(0, 3) == InferiorSlot::DEAD);
+
+        // Leaving them out of the moves, only when used.
+        vector< pair<unsigned, unsigned> > moves
+            = board.unoccupied_list_get();
+        board.inferior_slots_remove(moves);
+        assert(moves.size() == board.unoccupied_list_get().size());
+        // The corner (0, 0) and (0, 1) are now captured by O as well.
+        assert(board.inferior_get(0, 0) == InferiorSlot::CAPTURED_O);
+        assert(board.inferior_get(0, 1) == InferiorSlot::CAPTURED_O);
+        board.inferior_slots_use(true);
+        board.inferior_slots_remove(moves);
+        assert(moves.size() == board.unoccupied_list_get().size() - 3);
+        for (auto move: moves) {
+            assert(board.inferior_get(move.first, move.second)
+                   == InferiorSlot::NONE);
+        }
+        assert(board.sanity_check());
+    }
+}
+
+// True if X wins once board is full: forced first, then the other free
+// slots at random from seed, the same ones whatever forced.
+static bool X_win_full_check(
+    HexBoard board,
+    const vector< pair<pair<unsigned, unsigned>, Player> >& forced,
+    const unsigned seed)
+{
+    vector< pair<unsigned, unsigned> > slots = board.unoccupied_list_get();
+    sort(slots.begin(), slots.end());
+    mt19937 engine(seed);
+    for (auto slot: slots) {
+        const bool X = (engine() & 1);
+        board.place(slot, X ? player_X : player_O);
+    }
+    for (auto stone: forced) {
+        board.unplace(stone.first);
+        board.place(stone.first, stone.second);
+    }
+    return board.win_check(player_X);
+}
+
+// The inferior slots of random positions against the winners of random
+// fills: a dead slot never changes the winner, and a captured pair owned
+// by P wins as when P has both, if the other player has either one.
+void test_hexboard_inferior_sound()
+{
+    cout << __func__ << endl;
+    unsigned nb_dead = 0;
+    unsigned nb_captured = 0;
+    for (unsigned size: {5, 7}) {
+        for (unsigned position = 0; position < 40; ++position) {
+            HexBoard board(size, position + 1);
+            Player player = player_X;
+            for (unsigned i = 0; i < size * size / 2; ++i) {
+                const vector< pair<unsigned, unsigned> >& free_slots
+                    = board.unoccupied_list_get();
+                board.place(free_slots[board.random_draw() % free_slots.size()],
+                            player);
+                player.swap();
+            }
+
+            const vector< pair<unsigned, unsigned> > free_slots
+                = board.unoccupied_list_get();
+            for (auto a: free_slots) {
+                const InferiorSlot kind = board.inferior_get(a.first, a.second);
+                if (kind == InferiorSlot::DEAD) {
+                    ++nb_dead;
+                    for (unsigned seed = 0; seed < 30; ++seed) {
+                        assert(X_win_full_check(board, {{a, player_X}}, seed)
+                               == X_win_full_check(board, {{a, player_O}},
+                                                   seed));
+                    }
+                } else if (kind != InferiorSlot::NONE) {
+                    ++nb_captured;
+                    Player owner = (kind == InferiorSlot::CAPTURED_X) ?
+                        player_X : player_O;
+                    Player other = owner;
+                    other.swap();
+                    // One of the neighbours captured with a is its pair.
+                    bool paired = false;
+                    for (auto b: free_slots) {
+                        const int dc = int(b.first) - int(a.first);
+                        const int dr = int(b.second) - int(a.second);
+                        if ((abs(dc) > 1) || (abs(dr) > 1) || (dc == dr)
+                            || (board.inferior_get(b.first, b.second)
+                                != kind)) {
+                            continue;
+                        }
+                        bool same = true;
+                        for (unsigned seed = 0; same && (seed < 30); ++seed) {
+                            const bool win = X_win_full_check(
+                                board, {{a, owner}, {b, owner}}, seed);
+                            same = (win == X_win_full_check(
+                                        board, {{a, other}, {b, owner}}, seed))
+                                && (win == X_win_full_check(
+                                        board, {{a, owner}, {b, other}},
+                                        seed));
+                        }
+                        paired = paired || same;
+                    }
+                    assert(paired);
+                }
+            }
+        }
+    }
+    assert((nb_dead > 0) && (nb_captured > 0));
+}
+
+void test_hexboard_inferior_playouts()
+{
+    cout << __func__ << endl;
+    // A position with slots of all kinds.
+    HexBoard board(7, 1);
+    for (unsigned seed = 1; ; ++seed) {
+        board = HexBoard(7, seed);
+        Player player = player_X;
+        for (unsigned i = 0; i < 20; ++i) {
+            const vector< pair<unsigned, unsigned> >& free_slots
+                = board.unoccupied_list_get();
+            board.place(free_slots[board.random_draw() % free_slots.size()],
+                        player);
+            player.swap();
+        }
+        unsigned kinds = 0;
+        for (auto slot: board.unoccupied_list_get()) {
+            kinds |= 1 << static_cast<unsigned>(
+                board.inferior_get(slot.first, slot.second));
+        }
+        if (kinds == 0xf) {
+            break;
+        }
+    }
+
+    board.inferior_slots_use(true);
+    for (Player player: {player_X, player_O}) {
+        board.player_select(player);
+        board.occupied_save();
+        const InferiorSlot own = (player.get() == player_e::X) ?
+            InferiorSlot::CAPTURED_X : InferiorSlot::CAPTURED_O;
+        for (unsigned i = 0; i < 100; ++i) {
+            board.fill_up_half_and_win_check();
+            assert(board.playout_nb_stones_get()
+                   == board.unoccupied_list_get().size() / 2);
+            // The captured slots go to their owner, the dead ones to the
+            // other player while there is room.
+            for (auto slot: board.unoccupied_list_get()) {
+                const InferiorSlot kind
+                    = board.inferior_get(slot.first, slot.second);
+                if (kind != InferiorSlot::NONE) {
+                    assert(playout_stone_check(board, slot) == (kind == own));
+                }
+            }
+            board.occupied_restore();
+        }
+    }
+    assert(board.sanity_check());
+}
@@ -0,0 +1,141 @@
+/*----------------------------------------------------------------------------
+Unit test for the class HexGroups
+----------------------------------------------------------------------------*/
+
+// Module under test
+#include "../hexgroups.hpp"
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+
+#include "../player.hpp"
+
+using namespace std;
+
+//******************************************************************************
+// Module variables
+//******************************************************************************
+static const Player player_O(player_e::O);
+static const Player player_X(player_e::X);
+
+//******************************************************************************
+// Function prototypes
+//******************************************************************************
+void test_hexgroups_win_X();
+void test_hexgroups_win_O();
+void test_hexgroups_group_get();
+void test_hexgroups_undo();
+void test_hexgroups_remove_not_last();
+
+int main(void)
+{
+    test_hexgroups_win_X();
+    test_hexgroups_win_O();
+    test_hexgroups_group_get();
+    test_hexgroups_undo();
+    test_hexgroups_remove_not_last();
+    cout << endl << "All tested passed." << endl;
+    return 0;
+}
+
+void test_hexgroups_win_X()
+{
+    cout << __func__ << endl;
+    HexGroups groups(3);
+
+    // Zigzag from north to south, through the 7 o'clock neighbor.
+    groups.stone_add(2, 0, player_X);
+    assert(!groups.win_check(player_X));
+    groups.stone_add(1, 1, player_X);
+    assert(!groups.win_check(player_X));
+    groups.stone_add(1, 2, player_X);
+    assert(groups.win_check(player_X));
+    assert(!groups.win_check(player_O));
+}
+
+void test_hexgroups_win_O()
+{
+    cout << __func__ << endl;
+    HexGroups groups(3);
+
+    // (1, 1) is the neighbor of (2, 0) at 1 o'clock, and of (0, 2) at 7
+    // o'clock.
+    groups.stone_add(0, 2, player_O);
+    groups.stone_add(2, 0, player_O);
+    assert(!groups.win_check(player_O));
+    groups.stone_add(1, 1, player_O);
+    assert(groups.win_check(player_O));
+    assert(!groups.win_check(player_X));
+}
+
+void test_hexgroups_group_get()
+{
+    cout << __func__ << endl;
+    HexGroups groups(4);
+
+    groups.stone_add(0, 0, player_X);
+    groups.stone_add(1, 0, player_X);
+    groups.stone_add(3, 3, player_X);
+    // Neighbors, but not the same player.
+    groups.stone_add(2, 0, player_O);
+
+    assert(groups.group_get(0, 0) == groups.group_get(1, 0));
+    assert(groups.group_get(0, 0) != groups.group_get(3, 3));
+    assert(groups.group_get(1, 0) != groups.group_get(2, 0));
+    assert(groups.group_get(0, 0) == groups.side_group_get(groups.north_get()));
+    assert(groups.group_get(3, 3) == groups.side_group_get(groups.south_get()));
+    assert(groups.group_get(3, 3) != groups.side_group_get(groups.east_get()));
+
+    // An empty slot is its own group.
+    assert(groups.group_get(2, 2) == 2 * 4 + 2);
+}
+
+void test_hexgroups_undo()
+{
+    cout << __func__ << endl;
+    HexGroups groups(3);
+
+    groups.stone_add(1, 0, player_X);
+    groups.stone_add(1, 1, player_X);
+    groups.stone_add(1, 2, player_X);
+    assert(groups.win_check(player_X));
+
+    // Taken back last first, as a search does.
+    groups.stone_remove(1, 2);
+    assert(!groups.win_check(player_X));
+    assert(groups.group_get(1, 0) == groups.group_get(1, 1));
+    groups.stone_remove(1, 1);
+    assert(groups.group_get(1, 0) != groups.group_get(1, 1));
+    assert(groups.group_get(1, 1) == 1 * 3 + 1);
+
+    groups.stone_add(0, 2, player_X);
+    groups.stone_add(0, 1, player_X);
+    assert(groups.win_check(player_X));
+}
+
+void test_hexgroups_remove_not_last()
+{
+    cout << __func__ << endl;
+    HexGroups groups(3);
+
+    groups.stone_add(1, 0, player_X);
+    groups.stone_add(1, 1, player_X);
+    groups.stone_add(1, 2, player_X);
+    groups.stone_add(0, 0, player_O);
+
+    // Not the last stone added, the groups are rebuilt.
+    groups.stone_remove(1, 1);
+    assert(!groups.win_check(player_X));
+    assert(groups.group_get(1, 0) != groups.group_get(1, 2));
+
+    // Stones added after the rebuild can still be undone.
+    groups.stone_add(1, 1, player_X);
+    assert(groups.win_check(player_X));
+    groups.stone_remove(1, 1);
+    assert(!groups.win_check(player_X));
+
+    // And stones from before the rebuild removed.
+    groups.stone_remove(1, 0);
+    assert(groups.group_get(1, 0) == 1);
+}
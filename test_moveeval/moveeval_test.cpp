@@ -6,6 +6,7 @@ Unit test for the class HexGame and HexGameEvaluator
 #include "../moveeval.hpp"
 
 #include <cassert>
+#include <chrono>
 #include <cstdlib>
 #include <iostream>
 #include <vector>
@@ -25,11 +26,31 @@ static const Player player_X(player_e::X);
 //******************************************************************************
 void test_moveeval_constructor();
 void test_moveeval_best_move();
+void test_moveeval_threads_reproducible();
+void test_moveeval_seed();
+void test_moveeval_deadline();
+void test_moveeval_halving();
+void test_moveeval_halving_deadline();
+void test_moveeval_deadline_large();
+void test_moveeval_amaf();
+void test_moveeval_transposition();
+void test_moveeval_symmetry();
+void test_moveeval_inferior();
 
 int main(void)
 {
     test_moveeval_constructor();
     test_moveeval_best_move();
+    test_moveeval_threads_reproducible();
+    test_moveeval_seed();
+    test_moveeval_deadline();
+    test_moveeval_halving();
+    test_moveeval_halving_deadline();
+    test_moveeval_deadline_large();
+    test_moveeval_amaf();
+    test_moveeval_transposition();
+    test_moveeval_symmetry();
+    test_moveeval_inferior();
     cout << endl << "All tested passed." << endl;
     return 0;
 }
@@ -57,3 +78,270 @@ void test_moveeval_best_move()
 
     assert((best_move.first == 2) && (best_move.second == 0));
 }
+
+void test_moveeval_threads_reproducible()
+{
+    cout << __func__ << endl;
+    vector< pair<unsigned, unsigned> > best_moves;
+
+    for (unsigned nb_threads = 1; nb_threads <= 4; ++nb_threads) {
+        HexBoard board(7);
+        board.random_seed(1234);
+        board.play(3, 3, player_X);
+        board.play(2, 4, player_O);
+
+        MoveEvaluator evaluator(board, player_X, 20000, 500, nb_threads);
+        best_moves.push_back(evaluator.best_move_calculate());
+        assert(evaluator.nb_simulations_get() == 47 * 425);
+    }
+
+    // Same seed, same result, whatever the number of threads.
+    for (auto move: best_moves) {
+        assert(move == best_moves[0]);
+    }
+}
+
+void test_moveeval_seed()
+{
+    cout << __func__ << endl;
+    vector< pair<unsigned, unsigned> > best_moves;
+
+    for (unsigned nb_threads = 1; nb_threads <= 3; ++nb_threads) {
+        // The boards are not seeded: the seed of the evaluator decides.
+        HexBoard board(7);
+        board.play(3, 3, player_X);
+        board.play(2, 4, player_O);
+
+        MoveEvaluator evaluator(board, player_X, 20000, 500, nb_threads, 99);
+        best_moves.push_back(evaluator.best_move_calculate());
+    }
+
+    for (auto move: best_moves) {
+        assert(move == best_moves[0]);
+    }
+}
+
+void test_moveeval_deadline()
+{
+    cout << __func__ << endl;
+    HexBoard board(11);
+
+    // Way more simulations than can run before the deadline.
+    MoveEvaluator evaluator(board, player_X, UINT_MAX, UINT_MAX);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    evaluator.deadline_set(start + chrono::milliseconds(100));
+    evaluator.best_move_calculate();
+    chrono::duration<double, milli> elapsed
+        = chrono::steady_clock::now() - start;
+
+    assert(elapsed.count() >= 100.0);
+    assert(elapsed.count() < 500.0);
+    assert(evaluator.nb_simulations_get() > 0);
+}
+
+void test_moveeval_halving()
+{
+    cout << __func__ << endl;
+    vector< pair<unsigned, unsigned> > best_moves;
+
+    for (unsigned nb_threads = 1; nb_threads <= 3; ++nb_threads) {
+        HexBoard board(7);
+        board.play(3, 3, player_X);
+        board.play(2, 4, player_O);
+
+        MoveEvaluator evaluator(board, player_X, 20000, 500, nb_threads, 99);
+        evaluator.strategy_set(EvalStrategy::SUCCESSIVE_HALVING);
+        best_moves.push_back(evaluator.best_move_calculate());
+        // Same total as UNIFORM, 47 * 425, up to the rounding of the shares
+        // of the 6 rounds.
+        assert(evaluator.nb_simulations_get() <= 47 * 425);
+        assert(evaluator.nb_simulations_get() > 47 * 425 - 6 * 47);
+    }
+
+    for (auto move: best_moves) {
+        assert(move == best_moves[0]);
+    }
+
+    // The only move that does not lose.
+    HexBoard board(3);
+    board.play(0, 0, player_O);
+    board.play(1, 0, player_O);
+    MoveEvaluator evaluator(board, player_X);
+    evaluator.strategy_set(EvalStrategy::SUCCESSIVE_HALVING);
+    pair<unsigned, unsigned> best_move = evaluator.best_move_calculate();
+    assert((best_move.first == 2) && (best_move.second == 0));
+}
+
+void test_moveeval_halving_deadline()
+{
+    cout << __func__ << endl;
+    HexBoard board(11);
+
+    MoveEvaluator evaluator(board, player_X, UINT_MAX, UINT_MAX);
+    evaluator.strategy_set(EvalStrategy::SUCCESSIVE_HALVING);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    evaluator.deadline_set(start + chrono::milliseconds(100));
+    evaluator.best_move_calculate();
+    chrono::duration<double, milli> elapsed
+        = chrono::steady_clock::now() - start;
+
+    assert(elapsed.count() >= 100.0);
+    assert(elapsed.count() < 500.0);
+    assert(evaluator.nb_simulations_get() > 0);
+}
+
+// On the largest board, one batch per test move takes seconds: the deadline
+// must stop the first round too.
+void test_moveeval_deadline_large()
+{
+    cout << __func__ << endl;
+    HexBoard board(hexboard_max_size);
+
+    for (auto strategy: {EvalStrategy::UNIFORM,
+                         EvalStrategy::SUCCESSIVE_HALVING}) {
+        for (unsigned ms: {0, 20}) {
+            MoveEvaluator evaluator(board, player_X, UINT_MAX, UINT_MAX);
+            evaluator.strategy_set(strategy);
+            chrono::steady_clock::time_point start
+                = chrono::steady_clock::now();
+            evaluator.deadline_set(start + chrono::milliseconds(ms));
+            const pair<unsigned, unsigned> move
+                = evaluator.best_move_calculate();
+            chrono::duration<double, milli> elapsed
+                = chrono::steady_clock::now() - start;
+
+            assert(elapsed.count() >= ms);
+            assert(elapsed.count() < ms + 200.0);
+            assert(evaluator.nb_simulations_get() > 0);
+            assert((move.first < board.size_get())
+                   && (move.second < board.size_get()));
+            assert((evaluator.best_score_get() >= 0.0)
+                   && (evaluator.best_score_get() <= 1.0));
+        }
+    }
+}
+
+void test_moveeval_amaf()
+{
+    cout << __func__ << endl;
+
+    // Boards of 16 rows or less use PlayoutBatch, bigger ones not.
+    for (unsigned size: {7, 17}) {
+        vector< pair<unsigned, unsigned> > best_moves;
+        for (unsigned nb_threads = 1; nb_threads <= 3; ++nb_threads) {
+            HexBoard board(size);
+            board.play(3, 3, player_X);
+            board.play(2, 4, player_O);
+
+            MoveEvaluator evaluator(board, player_X, 20000, 100, nb_threads,
+                                    99);
+            evaluator.amaf_set(true);
+            best_moves.push_back(evaluator.best_move_calculate());
+        }
+        for (auto move: best_moves) {
+            assert(move == best_moves[0]);
+        }
+    }
+
+    for (auto strategy: {EvalStrategy::UNIFORM,
+                         EvalStrategy::SUCCESSIVE_HALVING}) {
+        // The only move that does not lose.
+        HexBoard board(3);
+        board.play(0, 0, player_O);
+        board.play(1, 0, player_O);
+        MoveEvaluator evaluator(board, player_X);
+        evaluator.strategy_set(strategy);
+        evaluator.amaf_set(true);
+        pair<unsigned, unsigned> best_move = evaluator.best_move_calculate();
+        assert((best_move.first == 2) && (best_move.second == 0));
+    }
+}
+
+void test_moveeval_transposition()
+{
+    cout << __func__ << endl;
+    TranspositionTable table(16);
+    HexBoard board(7);
+    board.play(3, 3, player_X);
+    board.play(2, 4, player_O);
+
+    MoveEvaluator evaluator(board, player_X, 20000, 500, 1, 99);
+    evaluator.transposition_table_set(&table);
+    const pair<unsigned, unsigned> move = evaluator.best_move_calculate();
+
+    // Every test move was stored, with its simulations.
+    TranspositionStats stats;
+    for (auto test: board.unoccupied_list_get()) {
+        assert(table.probe(board.canonical_hash_after_get(test, player_X),
+                           stats));
+        assert(stats.simulations == 425);
+    }
+
+    // The same evaluation again adds to them, and with twice the same
+    // simulations, finds the same move.
+    MoveEvaluator again(board, player_X, 20000, 500, 1, 99);
+    again.transposition_table_set(&table);
+    assert(again.best_move_calculate() == move);
+    assert(table.probe(board.canonical_hash_after_get(move, player_X),
+                       stats));
+    assert(stats.simulations == 850);
+}
+
+void test_moveeval_symmetry()
+{
+    cout << __func__ << endl;
+    // Empty 5x5 board: 25 test moves, 12 pairs of rotations and the center.
+    HexBoard board(5);
+    MoveEvaluator evaluator(board, player_X, 25 * 200, 200, 1, 5);
+    pair<unsigned, unsigned> move = evaluator.best_move_calculate();
+    assert(evaluator.nb_simulations_get() == 13 * 200);
+    assert((move.first < 5) && (move.second < 5));
+
+    MoveEvaluator all(board, player_X, 25 * 200, 200, 1, 5);
+    all.symmetry_set(false);
+    all.best_move_calculate();
+    assert(all.nb_simulations_get() == 25 * 200);
+
+    // Still symmetric with a stone and its rotation, but not with only one of
+    // them.
+    board.place(1, 0, player_X);
+    board.place(3, 4, player_X);
+    MoveEvaluator pair_placed(board, player_O, 23 * 200, 200, 1, 5);
+    pair_placed.best_move_calculate();
+    assert(pair_placed.nb_simulations_get() == 12 * 200);
+    board.unplace(3, 4);
+    MoveEvaluator single(board, player_O, 24 * 200, 200, 1, 5);
+    single.best_move_calculate();
+    assert(single.nb_simulations_get() == 24 * 200);
+}
+
+void test_moveeval_inferior()
+{
+    cout << __func__ << endl;
+    // Dead slots at (3, 3) and (0, 3), a pair captured by O in the corner
+    // (see test_hexboard_inferior_patterns()).
+    HexBoard board(7);
+    board.place(4, 3, player_X);
+    board.place(4, 2, player_X);
+    board.place(3, 2, player_X);
+    board.place(2, 3, player_X);
+    board.place(0, 2, player_O);
+    board.place(0, 4, player_O);
+    unsigned nb_useful = 0;
+    for (auto slot: board.unoccupied_list_get()) {
+        nb_useful += (board.inferior_get(slot.first, slot.second)
+                      == InferiorSlot::NONE);
+    }
+    assert(nb_useful <= 43 - 4);
+
+    MoveEvaluator all(board, player_O, 43 * 100, 100, 1, 5);
+    all.best_move_calculate();
+    assert(all.nb_simulations_get() == 43 * 100);
+
+    // Same simulations per test move, on fewer of them.
+    board.inferior_slots_use(true);
+    MoveEvaluator pruned(board, player_O, 43 * 100, 100, 1, 5);
+    const pair<unsigned, unsigned> move = pruned.best_move_calculate();
+    assert(pruned.nb_simulations_get() == nb_useful * 100);
+    assert(board.inferior_get(move.first, move.second) == InferiorSlot::NONE);
+}
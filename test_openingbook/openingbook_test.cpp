@@ -0,0 +1,162 @@
+/*----------------------------------------------------------------------------
+Unit test for the classes OpeningBook and OpeningBookGenerator
+----------------------------------------------------------------------------*/
+
+// Module under test
+#include "../openingbook.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "../hexboard.hpp"
+
+using namespace std;
+
+//******************************************************************************
+// Module variables
+//******************************************************************************
+static const Player player_X(player_e::X);
+static const Player player_O(player_e::O);
+static const char book_filename[] = "test.book";
+
+//******************************************************************************
+// Function prototypes
+//******************************************************************************
+void test_openingbook_open_errors();
+void test_openingbook_write_probe();
+void test_openingbook_generate();
+
+int main(void)
+{
+    test_openingbook_open_errors();
+    test_openingbook_write_probe();
+    test_openingbook_generate();
+    remove(book_filename);
+    cout << endl << "All tested passed." << endl;
+    return 0;
+}
+
+void test_openingbook_open_errors()
+{
+    cout << __func__ << endl;
+    OpeningBook book;
+    assert(!book.open("no_such.book"));
+
+    // Not a book.
+    ofstream file(book_filename, ios::trunc);
+    file << "this is not a book, but it is long enough for a header" << endl;
+    file.close();
+    assert(!book.open(book_filename));
+    assert(book.nb_entries_get() == 0);
+
+    // Nothing found in no book.
+    HexBoard board(5);
+    pair<unsigned, unsigned> move;
+    assert(!book.probe(board, player_X, move));
+}
+
+void test_openingbook_write_probe()
+{
+    cout << __func__ << endl;
+    HexBoard board(5);
+    board.place(1, 0, player_X);
+    board.place(2, 2, player_O);
+
+    // Moves of the book are on the canonical form of the board.
+    vector<OpeningBookEntry> entries(2);
+    const pair<unsigned, unsigned> move(4, 1);
+    const pair<unsigned, unsigned> canonical = board.canonical_move_get(move);
+    entries[0].key = board.canonical_hash_get(player_X);
+    entries[0].simulations = 1000;
+    entries[0].move = canonical.second * 5 + canonical.first;
+    entries[0].win_rate = 65535;
+    HexBoard empty(5);
+    entries[1].key = empty.canonical_hash_get(player_X);
+    entries[1].simulations = 1000;
+    entries[1].move = 2 * 5 + 2;
+    entries[1].win_rate = 0;
+    assert(OpeningBook::write(book_filename, entries));
+
+    OpeningBook book;
+    assert(book.open(book_filename));
+    assert(book.nb_entries_get() == 2);
+
+    pair<unsigned, unsigned> found;
+    double win_rate = 0.5;
+    assert(book.probe(board, player_X, found, &win_rate));
+    assert(found == move);
+    assert(win_rate == 1.0);
+    assert(!book.probe(board, player_O, found));
+
+    // The rotated position gets the rotated move.
+    HexBoard rotated(5);
+    rotated.place(board.rotated_get(make_pair(1, 0)), player_X);
+    rotated.place(board.rotated_get(make_pair(2, 2)), player_O);
+    assert(book.probe(rotated, player_X, found));
+    assert(found == rotated.rotated_get(move));
+
+    assert(book.probe(empty, player_X, found, &win_rate));
+    assert((found == make_pair(2u, 2u)) && (win_rate == 0.0));
+
+    // Not on other board sizes.
+    HexBoard other(6);
+    assert(!book.probe(other, player_X, found));
+
+    // Reopening replaces the book.
+    book.close();
+    assert(!book.probe(empty, player_X, found));
+    assert(book.open(book_filename));
+    assert(book.probe(empty, player_X, found));
+}
+
+void test_openingbook_generate()
+{
+    cout << __func__ << endl;
+    OpeningBookGenerator generator(3, 200, 1, 1);
+    generator.size_add(4);
+    generator.size_add(5);
+    assert(OpeningBook::write(book_filename, generator.entries_get()));
+    OpeningBook book;
+    assert(book.open(book_filename));
+    assert(book.nb_entries_get() == generator.entries_get().size());
+
+    for (unsigned size: {4u, 5u}) {
+        HexBoard board(size);
+        pair<unsigned, unsigned> x_move;
+        assert(book.probe(board, player_X, x_move));
+        assert(!board.occupied_check(x_move.first, x_move.second));
+
+        // X's book move, then any answer of O: X has a book move.
+        board.place(x_move, player_X);
+        const vector< pair<unsigned, unsigned> > replies
+            = board.unoccupied_list_get();
+        for (auto reply: replies) {
+            board.place(reply, player_O);
+            pair<unsigned, unsigned> move;
+            assert(book.probe(board, player_X, move));
+            assert(!board.occupied_check(move.first, move.second));
+            board.unplace(reply);
+        }
+        board.unplace(x_move);
+
+        // Any first move of X: O has a book move.
+        for (unsigned lin = 0; lin < size * size; ++lin) {
+            board.place(lin % size, lin / size, player_X);
+            pair<unsigned, unsigned> move;
+            assert(book.probe(board, player_O, move));
+            assert(!board.occupied_check(move.first, move.second));
+            board.unplace(lin % size, lin / size);
+        }
+
+        // Out of the book after three moves.
+        board.place(0, 0, player_X);
+        board.place(1, 0, player_O);
+        board.place(2, 0, player_X);
+        pair<unsigned, unsigned> move;
+        assert(!book.probe(board, player_O, move));
+    }
+}
@@ -0,0 +1,100 @@
+/*----------------------------------------------------------------------------
+Unit test for the class PlayoutBatch
+----------------------------------------------------------------------------*/
+
+// Module under test
+#include "../playoutbatch.hpp"
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "../hexboard.hpp"
+#include "../player.hpp"
+
+using namespace std;
+
+//******************************************************************************
+// Module variables
+//******************************************************************************
+static const Player player_O(player_e::O);
+static const Player player_X(player_e::X);
+
+//******************************************************************************
+// Function prototypes
+//******************************************************************************
+void test_playoutbatch_kernels();
+void test_playoutbatch_partial();
+
+int main(void)
+{
+    test_playoutbatch_kernels();
+    test_playoutbatch_partial();
+    cout << endl << "All tested passed." << endl;
+    return 0;
+}
+
+// Every kernel the CPU has must agree with HexBoard::win_check(), for all the
+// board sizes and both players.
+void test_playoutbatch_kernels()
+{
+    cout << __func__ << endl;
+    for (auto kernel: {PlayoutBatch::Kernel::SCALAR,
+                       PlayoutBatch::Kernel::SSE2,
+                       PlayoutBatch::Kernel::AVX2}) {
+        if (kernel > PlayoutBatch::kernel_best()) {
+            continue;
+        }
+        cout << "  " << PlayoutBatch::kernel_name(kernel) << endl;
+
+        for (unsigned size = 1; size <= 16; ++size) {
+            assert(PlayoutBatch::size_supported(size));
+            PlayoutBatch playouts(size);
+            playouts.kernel_set(kernel);
+            HexBoard board(size);
+            board.random_seed(size);
+
+            for (unsigned batch = 0; batch < 20; ++batch) {
+                Player player = (batch % 2 == 0) ? player_X : player_O;
+                board.player_select(player);
+                board.occupied_save();
+                uint32_t expected = 0;
+                for (unsigned b = 0; b < PlayoutBatch::max_nb_boards; ++b) {
+                    board.fill_up_half();
+                    if (board.win_check(player)) {
+                        expected |= uint32_t(1) << b;
+                    }
+                    playouts.board_add(board);
+                    board.occupied_restore();
+                }
+                assert(playouts.win_check() == expected);
+            }
+        }
+    }
+}
+
+// A batch that is not full only reports on its own boards.
+void test_playoutbatch_partial()
+{
+    cout << __func__ << endl;
+    HexBoard full(3);
+    full.place(0, 0, player_X);
+    full.place(0, 1, player_X);
+    full.place(0, 2, player_X);
+    full.player_select(player_X);
+    HexBoard empty(3);
+    empty.player_select(player_X);
+
+    PlayoutBatch playouts(3);
+    for (unsigned b = 0; b < PlayoutBatch::max_nb_boards; ++b) {
+        playouts.board_add(full);
+    }
+    assert(playouts.win_check() == 0xffff);
+    assert(playouts.nb_boards_get() == 0);
+
+    playouts.board_add(empty);
+    playouts.board_add(full);
+    playouts.board_add(empty);
+    assert(playouts.win_check() == 0x2);
+}
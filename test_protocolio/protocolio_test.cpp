@@ -0,0 +1,190 @@
+/*----------------------------------------------------------------------------
+Unit test for the classes ProtocolReader and ProtocolWriter
+----------------------------------------------------------------------------*/
+
+// Module under test
+#include "../protocolio.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <poll.h>
+#include <unistd.h>
+
+using namespace std;
+
+//******************************************************************************
+// Function prototypes
+//******************************************************************************
+void test_protocolio_lines();
+void test_protocolio_timeout();
+void test_protocolio_long_line();
+void test_protocolio_end();
+void test_protocolio_writer();
+
+static void text_write(const int fd, const char* text);
+
+int main(void)
+{
+    test_protocolio_lines();
+    test_protocolio_timeout();
+    test_protocolio_long_line();
+    test_protocolio_end();
+    test_protocolio_writer();
+    cout << endl << "All tested passed." << endl;
+    return 0;
+}
+
+void test_protocolio_lines()
+{
+    cout << __func__ << endl;
+    int fds[2];
+    assert(pipe(fds) == 0);
+    ProtocolReader reader(fds[0]);
+    string line;
+
+    // Several lines in one read.
+    text_write(fds[1], "O: Hexjakt\nXa1 #1 t=5ms\n\nOb2.\n");
+    assert(reader.line_read(line) == ProtocolRead::LINE);
+    assert(line == "O: Hexjakt");
+    assert(reader.line_read(line) == ProtocolRead::LINE);
+    assert(line == "Xa1 #1 t=5ms");
+    assert(reader.line_read(line) == ProtocolRead::LINE);
+    assert(line == "");
+    assert(reader.line_read(line) == ProtocolRead::LINE);
+    assert(line == "Ob2.");
+
+    // A line in several reads.
+    text_write(fds[1], "Xc");
+    assert(reader.line_read(line, 0) == ProtocolRead::TIMEOUT);
+    text_write(fds[1], "3 #3");
+    assert(reader.line_read(line, 0) == ProtocolRead::TIMEOUT);
+    text_write(fds[1], " t=7ms\nO");
+    assert(reader.line_read(line, 0) == ProtocolRead::LINE);
+    assert(line == "Xc3 #3 t=7ms");
+    text_write(fds[1], ".\n");
+    assert(reader.line_read(line) == ProtocolRead::LINE);
+    assert(line == "O.");
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+void test_protocolio_timeout()
+{
+    cout << __func__ << endl;
+    int fds[2];
+    assert(pipe(fds) == 0);
+    ProtocolReader reader(fds[0]);
+    string line;
+
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    assert(reader.line_read(line, 30) == ProtocolRead::TIMEOUT);
+    const chrono::duration<double, milli> elapsed
+        = chrono::steady_clock::now() - start;
+    assert(elapsed.count() >= 25.0);
+    assert(elapsed.count() < 1000.0);
+
+    // Nothing lost on timeout.
+    text_write(fds[1], "Xa");
+    assert(reader.line_read(line, 10) == ProtocolRead::TIMEOUT);
+    text_write(fds[1], "1\n");
+    assert(reader.line_read(line, 10) == ProtocolRead::LINE);
+    assert(line == "Xa1");
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+// Longer than the buffer: it grows, the line comes out whole.
+void test_protocolio_long_line()
+{
+    cout << __func__ << endl;
+    int fds[2];
+    assert(pipe(fds) == 0);
+    ProtocolReader reader(fds[0]);
+    string line;
+
+    text_write(fds[1], "Xa1\n");
+    const string long_line(10000, 'x');
+    for (unsigned i = 0; i < long_line.size(); i += 1000) {
+        text_write(fds[1], long_line.substr(i, 1000).c_str());
+    }
+    text_write(fds[1], "\nOb2\n");
+    assert(reader.line_read(line) == ProtocolRead::LINE);
+    assert(line == "Xa1");
+    assert(reader.line_read(line) == ProtocolRead::LINE);
+    assert(line == long_line);
+    assert(reader.line_read(line) == ProtocolRead::LINE);
+    assert(line == "Ob2");
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+void test_protocolio_end()
+{
+    cout << __func__ << endl;
+    int fds[2];
+    assert(pipe(fds) == 0);
+    ProtocolReader reader(fds[0]);
+    string line;
+
+    // The last line has no '\n'.
+    text_write(fds[1], "Xa1\nOb2.");
+    close(fds[1]);
+    assert(reader.line_read(line) == ProtocolRead::LINE);
+    assert(line == "Xa1");
+    assert(reader.line_read(line) == ProtocolRead::LINE);
+    assert(line == "Ob2.");
+    assert(reader.line_read(line) == ProtocolRead::END);
+    assert(reader.line_read(line, 0) == ProtocolRead::END);
+
+    // A new descriptor starts afresh.
+    assert(pipe(fds) == 0);
+    reader.descriptor_set(fds[0]);
+    text_write(fds[1], "Xc3\n");
+    assert(reader.line_read(line) == ProtocolRead::LINE);
+    assert(line == "Xc3");
+    close(fds[0]);
+    close(fds[1]);
+}
+
+void test_protocolio_writer()
+{
+    cout << __func__ << endl;
+    int fds[2];
+    assert(pipe(fds) == 0);
+    ProtocolWriter writer(fds[1]);
+
+    writer << Player(player_e::X) << 'a' << 10u << " #" << 0u << " t="
+           << 4294967295u << "ms\n";
+    writer << Player(player_e::O) << ".\n";
+
+    // Nothing written before the flush.
+    struct pollfd input = {fds[0], POLLIN, 0};
+    assert(poll(&input, 1, 0) == 0);
+
+    assert(writer.flush());
+    const char expected[] = "Xa10 #0 t=4294967295ms\nO.\n";
+    char text[sizeof(expected)] = {0};
+    assert(read(fds[0], text, sizeof(text) - 1)
+           == static_cast<ssize_t>(strlen(expected)));
+    assert(strcmp(text, expected) == 0);
+
+    // The buffer is empty after a flush.
+    assert(writer.flush());
+    assert(poll(&input, 1, 0) == 0);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+static void text_write(const int fd, const char* text)
+{
+    const ssize_t size = strlen(text);
+    assert(write(fd, text, size) == size);
+}
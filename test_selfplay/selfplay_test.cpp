@@ -0,0 +1,128 @@
+/*----------------------------------------------------------------------------
+Unit test for the class SelfPlayMatch
+----------------------------------------------------------------------------*/
+
+// Module under test
+#include "../selfplay.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+//******************************************************************************
+// Module variables
+//******************************************************************************
+static const SelfPlaySide side_flat = {
+    EngineType::FLAT_MC, 20, 0, false, false, PlayoutPolicy::UNIFORM, false
+};
+static const SelfPlaySide side_uct = {
+    EngineType::UCT, 100, 0, false, false, PlayoutPolicy::BRIDGES, true
+};
+
+//******************************************************************************
+// Function prototypes
+//******************************************************************************
+void test_selfplay_game();
+void test_selfplay_run();
+void test_selfplay_threads();
+void test_selfplay_confidence_interval();
+
+int main(void)
+{
+    test_selfplay_game();
+    test_selfplay_run();
+    test_selfplay_threads();
+    test_selfplay_confidence_interval();
+    cout << endl << "All tested passed." << endl;
+    return 0;
+}
+
+void test_selfplay_game()
+{
+    cout << __func__ << endl;
+    SelfPlayMatch match(5, side_uct, side_flat);
+    ostringstream progress;
+    match.progress_set(&progress);
+
+    for (unsigned index = 0; index < 4; ++index) {
+        const Player winner = match.game_play(index);
+        assert(winner.is_player());
+        // The same game again, with the same seeds.
+        assert(match.game_play(index).get() == winner.get());
+    }
+    assert(progress.str().find("game 4: ") != string::npos);
+}
+
+void test_selfplay_run()
+{
+    cout << __func__ << endl;
+    SelfPlayMatch match(5, side_uct, side_flat);
+    const SelfPlayResult result = match.run(7);
+    assert(result.nb_games == 7);
+    assert(result.wins_a <= 7);
+    // Side A is X in 4 games.
+    assert(result.wins_a_as_X <= 4);
+    assert(result.wins_a_as_X <= result.wins_a);
+    assert(result.wins_a - result.wins_a_as_X <= 3);
+    // X wins the games A wins as X, and those B wins as X.
+    const unsigned wins_a_as_O = result.wins_a - result.wins_a_as_X;
+    assert(result.wins_X == result.wins_a_as_X + (3 - wins_a_as_O));
+    assert(result.seconds > 0.0);
+    assert(result.games_per_hour_get() > 0.0);
+
+    // The same settings on both sides, the sides are still counted apart.
+    SelfPlayMatch mirror(5, side_flat, side_flat);
+    const SelfPlayResult mirror_result = mirror.run(4);
+    assert(mirror_result.wins_X
+           == mirror_result.wins_a_as_X
+           + (2 - (mirror_result.wins_a - mirror_result.wins_a_as_X)));
+}
+
+// With budgets in simulations, the games and so the results are the same
+// on any number of threads.
+void test_selfplay_threads()
+{
+    cout << __func__ << endl;
+    SelfPlayMatch match(5, side_uct, side_flat);
+    match.seed_set(7);
+    const SelfPlayResult serial = match.run(9);
+    match.threads_set(3);
+    const SelfPlayResult parallel = match.run(9);
+    assert(parallel.nb_games == serial.nb_games);
+    assert(parallel.wins_a == serial.wins_a);
+    assert(parallel.wins_a_as_X == serial.wins_a_as_X);
+    assert(parallel.wins_X == serial.wins_X);
+
+    // More threads than games.
+    match.threads_set(16);
+    assert(match.run(2).nb_games == 2);
+}
+
+void test_selfplay_confidence_interval()
+{
+    cout << __func__ << endl;
+    double center, half_width;
+
+    SelfPlayResult result = {100, 50, 25, 50, 1.0};
+    assert(result.win_rate_a_get() == 0.5);
+    result.confidence_interval_get(center, half_width);
+    assert((center > 0.5 - 1e-9) && (center < 0.5 + 1e-9));
+    // About 1.96 * sqrt(0.25 / 100).
+    assert((half_width > 0.09) && (half_width < 0.1));
+    assert(result.games_per_hour_get() == 360000.0);
+
+    // All won: the interval stays below 1, and is not empty.
+    result = {10, 10, 5, 5, 1.0};
+    result.confidence_interval_get(center, half_width);
+    assert(center + half_width <= 1.0 + 1e-9);
+    assert(center - half_width > 0.6);
+    assert(center - half_width < 0.8);
+
+    result = {0, 0, 0, 0, 0.0};
+    assert(result.win_rate_a_get() == 0.0);
+    result.confidence_interval_get(center, half_width);
+    assert((center == 0.5) && (half_width == 0.5));
+    assert(result.games_per_hour_get() == 0.0);
+}
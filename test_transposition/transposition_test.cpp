@@ -0,0 +1,179 @@
+/*----------------------------------------------------------------------------
+Unit test for the class TranspositionTable
+----------------------------------------------------------------------------*/
+
+// Module under test
+#include "../transposition.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//******************************************************************************
+// Function prototypes
+//******************************************************************************
+void test_transposition_size();
+void test_transposition_update_probe();
+void test_transposition_replace();
+void test_transposition_generation();
+void test_transposition_threads();
+
+int main(void)
+{
+    test_transposition_size();
+    test_transposition_update_probe();
+    test_transposition_replace();
+    test_transposition_generation();
+    test_transposition_threads();
+    cout << endl << "All tested passed." << endl;
+    return 0;
+}
+
+void test_transposition_size()
+{
+    cout << __func__ << endl;
+    TranspositionTable table(1);
+    assert(table.memory_size_get() <= 1024 * 1024);
+    assert(2 * table.memory_size_get() > 1024 * 1024);
+    // A power of two.
+    assert((table.nb_entries_get() & (table.nb_entries_get() - 1)) == 0);
+
+    TranspositionTable tiny(0);
+    assert(tiny.nb_entries_get() == 1);
+}
+
+void test_transposition_update_probe()
+{
+    cout << __func__ << endl;
+    TranspositionTable table(1);
+    TranspositionStats stats;
+
+    const uint64_t key = 0x123456789abcdef0ULL;
+    assert(!table.probe(key, stats));
+    // Nothing was stored at key 0 either, the empty entries do not match it.
+    assert(!table.probe(0, stats));
+
+    table.update(key, 3, 10);
+    table.update(key, 1, 5);
+    assert(table.probe(key, stats));
+    assert((stats.wins == 4) && (stats.simulations == 15));
+
+    // Same entry, other key.
+    assert(!table.probe(key + table.nb_entries_get(), stats));
+
+    table.clear();
+    assert(!table.probe(key, stats));
+}
+
+void test_transposition_replace()
+{
+    cout << __func__ << endl;
+    TranspositionTable table(1);
+    TranspositionStats stats;
+    const uint64_t key_a = 7;
+    const uint64_t key_b = 7 + table.nb_entries_get();
+
+    // The position with more simulations stays.
+    table.update(key_a, 50, 100);
+    table.update(key_b, 5, 10);
+    assert(table.probe(key_a, stats));
+    assert(!table.probe(key_b, stats));
+
+    table.update(key_b, 60, 100);
+    assert(!table.probe(key_a, stats));
+    assert(table.probe(key_b, stats));
+    assert((stats.wins == 60) && (stats.simulations == 100));
+
+    // Saturates instead of wrapping around, keeping the win rate.
+    const uint32_t max = TranspositionTable::simulations_max;
+    table.update(key_b, max / 2, max - 10);
+    assert(table.probe(key_b, stats));
+    assert(stats.simulations > max / 2);
+    assert(stats.wins > stats.simulations / 2 - 100);
+    assert(stats.wins < stats.simulations / 2 + 100);
+    // All won, with counts as large as they get.
+    table.update(key_a, UINT32_MAX, UINT32_MAX);
+    table.update(key_a, UINT32_MAX, UINT32_MAX);
+    assert(table.probe(key_a, stats));
+    assert(stats.simulations > max / 2);
+    assert(stats.simulations <= max);
+    assert(stats.wins > stats.simulations - 100);
+    assert(stats.wins <= stats.simulations);
+}
+
+// The entries of the previous searches make room for the current one.
+void test_transposition_generation()
+{
+    cout << __func__ << endl;
+    TranspositionTable table(1);
+    TranspositionStats stats;
+    const uint64_t key_a = 7;
+    const uint64_t key_b = 7 + table.nb_entries_get();
+
+    table.update(key_a, 500, 1000);
+    table.generation_next();
+    // Still there, and still kept in the same generation.
+    assert(table.probe(key_a, stats));
+    assert(stats.simulations == 1000);
+    table.update(key_a, 1, 1);
+    table.update(key_b, 1, 1);
+    assert(table.probe(key_a, stats));
+    assert((stats.wins == 501) && (stats.simulations == 1001));
+
+    // Not updated since the last generation: a single simulation replaces
+    // it.
+    table.generation_next();
+    table.update(key_b, 1, 1);
+    assert(!table.probe(key_a, stats));
+    assert(table.probe(key_b, stats));
+    assert((stats.wins == 1) && (stats.simulations == 1));
+
+    // Updated in every generation, around the generation counter.
+    for (unsigned i = 0; i < 1000; ++i) {
+        table.generation_next();
+        table.update(key_a, 0, 1);
+    }
+    assert(table.probe(key_a, stats));
+    assert((stats.wins == 0) && (stats.simulations == 1000));
+    table.generation_next();
+    table.update(key_b, 1, 1);
+    assert(table.probe(key_b, stats));
+}
+
+// Threads hammering the same few entries: there may be lost updates, but a
+// probe never returns the data of another key.
+void test_transposition_threads()
+{
+    cout << __func__ << endl;
+    TranspositionTable table(1);
+    const unsigned nb_keys = 4;
+
+    vector<thread> threads;
+    for (unsigned t = 0; t < 4; ++t) {
+        threads.push_back(thread([&table, t]() {
+            for (unsigned i = 0; i < 100000; ++i) {
+                // All the keys go to entry 0, key k always gets k wins out
+                // of k + 1 simulations.
+                const uint64_t k = (i + t) % nb_keys;
+                table.update(k * table.nb_entries_get() + (k << 60),
+                             k, k + 1);
+            }
+        }));
+    }
+    for (auto& thread: threads) {
+        thread.join();
+    }
+
+    for (uint64_t k = 0; k < nb_keys; ++k) {
+        TranspositionStats stats;
+        if (table.probe(k * table.nb_entries_get() + (k << 60), stats)) {
+            assert(uint64_t(stats.wins) * (k + 1)
+                   == uint64_t(stats.simulations) * k);
+        }
+    }
+}
@@ -0,0 +1,326 @@
+/*----------------------------------------------------------------------------
+Unit test for the class UctSearch
+----------------------------------------------------------------------------*/
+
+// Module under test
+#include "../uctsearch.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../hexboard.hpp"
+
+using namespace std;
+
+//******************************************************************************
+// Module variables
+//******************************************************************************
+static const Player player_O(player_e::O);
+static const Player player_X(player_e::X);
+
+//******************************************************************************
+// Function prototypes
+//******************************************************************************
+void test_uctsearch_constructor();
+void test_uctsearch_best_move();
+void test_uctsearch_block();
+void test_uctsearch_reproducible();
+void test_uctsearch_advance();
+void test_uctsearch_deadline();
+void test_uctsearch_transposition();
+void test_uctsearch_parallel();
+void test_uctsearch_parallel_deadline();
+void test_uctsearch_ponder();
+
+int main(void)
+{
+    test_uctsearch_constructor();
+    test_uctsearch_best_move();
+    test_uctsearch_block();
+    test_uctsearch_reproducible();
+    test_uctsearch_advance();
+    test_uctsearch_deadline();
+    test_uctsearch_transposition();
+    test_uctsearch_parallel();
+    test_uctsearch_parallel_deadline();
+    test_uctsearch_ponder();
+    cout << endl << "All tested passed." << endl;
+    return 0;
+}
+
+void test_uctsearch_constructor()
+{
+    cout << __func__ << endl;
+    HexBoard board(3);
+
+    board.play(0, 1, player_O);
+    board.play(1, 1, player_O);
+
+    UctSearch search(board, player_O);
+}
+
+void test_uctsearch_best_move()
+{
+    cout << __func__ << endl;
+    HexBoard board(3);
+    board.play(0, 0, player_O);
+    board.play(1, 0, player_O);
+
+    UctSearch search(board, player_O);
+    pair<unsigned, unsigned> best_move = search.best_move_calculate();
+
+    assert((best_move.first == 2) && (best_move.second == 0));
+    assert(search.best_score_get() == 1.0);
+}
+
+void test_uctsearch_block()
+{
+    cout << __func__ << endl;
+    HexBoard board(4);
+    board.random_seed(1);
+    // O wins at d1 next move, X must block it.
+    board.play(0, 0, player_O);
+    board.play(1, 0, player_O);
+    board.play(2, 0, player_O);
+    board.play(1, 2, player_X);
+    board.play(2, 2, player_X);
+
+    UctSearch search(board, player_X, 20000, 2000);
+    pair<unsigned, unsigned> best_move = search.best_move_calculate();
+
+    assert((best_move.first == 3) && (best_move.second == 0));
+    // The budget is the same as for the flat Monte-Carlo evaluation.
+    assert(search.nb_simulations_get() == 11 * 1818);
+    assert((search.best_score_get() > 0.0) && (search.best_score_get() < 1.0));
+
+    // A new budget, on the same tree.
+    search.simulations_set(UINT_MAX, 100);
+    best_move = search.best_move_calculate();
+    assert((best_move.first == 3) && (best_move.second == 0));
+    assert(search.nb_simulations_get() == 11 * 100);
+}
+
+void test_uctsearch_reproducible()
+{
+    cout << __func__ << endl;
+    vector< pair<unsigned, unsigned> > best_moves;
+
+    for (unsigned i = 0; i < 3; ++i) {
+        HexBoard board(7);
+        board.random_seed(1234);
+        board.play(3, 3, player_X);
+        board.play(2, 4, player_O);
+
+        UctSearch search(board, player_X, 20000, 500);
+        best_moves.push_back(search.best_move_calculate());
+    }
+
+    for (auto move: best_moves) {
+        assert(move == best_moves[0]);
+    }
+}
+
+void test_uctsearch_advance()
+{
+    cout << __func__ << endl;
+    HexBoard board(5);
+    board.random_seed(1);
+
+    UctSearch search(board, player_X, 50000, 2000);
+    pair<unsigned, unsigned> move = search.best_move_calculate();
+    unsigned long first_search_visits = search.root_visits_get();
+    assert(first_search_visits == search.nb_simulations_get());
+
+    // The subtree of the move played is kept, with its statistics.
+    board.play(move, player_X);
+    search.advance(move);
+    unsigned long kept_visits = search.root_visits_get();
+    assert(kept_visits > 0);
+    assert(kept_visits < first_search_visits);
+
+    // The next search adds to the kept statistics.
+    move = search.best_move_calculate();
+    assert(search.root_visits_get()
+           == kept_visits + search.nb_simulations_get());
+}
+
+void test_uctsearch_deadline()
+{
+    cout << __func__ << endl;
+    HexBoard board(11);
+
+    // Way more simulations than can run before the deadline.
+    UctSearch search(board, player_X, UINT_MAX, UINT_MAX);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    search.deadline_set(start + chrono::milliseconds(100));
+    search.best_move_calculate();
+    chrono::duration<double, milli> elapsed
+        = chrono::steady_clock::now() - start;
+
+    assert(elapsed.count() >= 100.0);
+    assert(elapsed.count() < 500.0);
+    assert(search.nb_simulations_get() > 0);
+}
+
+void test_uctsearch_transposition()
+{
+    cout << __func__ << endl;
+    TranspositionTable table(16);
+    HexBoard board(4);
+    board.random_seed(1);
+    // Same position as test_uctsearch_block().
+    board.play(0, 0, player_O);
+    board.play(1, 0, player_O);
+    board.play(2, 0, player_O);
+    board.play(1, 2, player_X);
+    board.play(2, 2, player_X);
+
+    UctSearch search(board, player_X, 20000, 2000);
+    search.transposition_table_set(&table);
+    pair<unsigned, unsigned> best_move = search.best_move_calculate();
+    assert((best_move.first == 3) && (best_move.second == 0));
+
+    // The root position got all the simulations.
+    TranspositionStats stats;
+    assert(table.probe(board.canonical_hash_get(player_X), stats));
+    assert(stats.simulations == search.nb_simulations_get());
+    assert(table.probe(board.canonical_hash_after_get(best_move, player_X),
+                       stats));
+
+    // A new search starts from the statistics of the first one: its root
+    // children are already visited.
+    UctSearch second(board, player_X, 20000, 2000);
+    second.transposition_table_set(&table);
+    best_move = second.best_move_calculate();
+    assert((best_move.first == 3) && (best_move.second == 0));
+}
+
+void test_uctsearch_parallel()
+{
+    cout << __func__ << endl;
+    // The position of test_uctsearch_block(), with 4 threads.
+    HexBoard board(4);
+    board.random_seed(1);
+    board.play(0, 0, player_O);
+    board.play(1, 0, player_O);
+    board.play(2, 0, player_O);
+    board.play(1, 2, player_X);
+    board.play(2, 2, player_X);
+
+    // All the simulations go through the shared tree.
+    UctSearch shared(board, player_X, 20000, 2000);
+    shared.threads_set(4);
+    pair<unsigned, unsigned> best_move = shared.best_move_calculate();
+    assert((best_move.first == 3) && (best_move.second == 0));
+    assert(shared.nb_simulations_get() == 11 * 1818);
+    assert(shared.root_visits_get() == 11 * 1818);
+
+    // The tree of the calling thread only has its share, 19998 / 4 rounded
+    // up.
+    UctSearch root(board, player_X, 20000, 2000);
+    root.threads_set(4);
+    root.parallel_set(UctParallel::ROOT);
+    best_move = root.best_move_calculate();
+    assert((best_move.first == 3) && (best_move.second == 0));
+    assert(root.nb_simulations_get() == 11 * 1818);
+    assert(root.root_visits_get() == 5000);
+
+    // Separate trees do not depend on the scheduling of the threads.
+    HexBoard board_1(board);
+    HexBoard board_2(board);
+    board_1.unplace(2, 0);
+    board_2.unplace(2, 0);
+    UctSearch root_1(board_1, player_X, 5000, 500);
+    UctSearch root_2(board_2, player_X, 5000, 500);
+    for (UctSearch* search: {&root_1, &root_2}) {
+        search->threads_set(3);
+        search->parallel_set(UctParallel::ROOT);
+    }
+    assert(root_1.best_move_calculate() == root_2.best_move_calculate());
+    assert(root_1.root_visits_get() == root_2.root_visits_get());
+
+    // The score is that of the move over all the trees, as the choice of the
+    // move, not that of the tree of the calling thread: about the same as
+    // with one tree.
+    for (unsigned seed = 1; seed <= 8; ++seed) {
+        HexBoard open_board(9, seed);
+        open_board.play(4, 4, player_X);
+        open_board.play(3, 3, player_O);
+        UctSearch one(open_board, player_X, UINT_MAX, 300);
+        one.best_move_calculate();
+        UctSearch two(open_board, player_X, UINT_MAX, 300);
+        two.threads_set(2);
+        two.parallel_set(UctParallel::ROOT);
+        two.best_move_calculate();
+        assert(fabs(two.best_score_get() - one.best_score_get()) < 0.1);
+    }
+}
+
+void test_uctsearch_parallel_deadline()
+{
+    cout << __func__ << endl;
+    HexBoard board(11);
+    for (auto mode: {UctParallel::TREE, UctParallel::ROOT}) {
+        UctSearch search(board, player_X, UINT_MAX, UINT_MAX);
+        search.threads_set(3);
+        search.parallel_set(mode);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        search.deadline_set(start + chrono::milliseconds(100));
+        search.best_move_calculate();
+        chrono::duration<double, milli> elapsed
+            = chrono::steady_clock::now() - start;
+
+        assert(elapsed.count() >= 100.0);
+        assert(elapsed.count() < 1000.0);
+        // At least a batch per thread.
+        assert(search.nb_simulations_get() >= 3 * 128);
+    }
+}
+
+void test_uctsearch_ponder()
+{
+    cout << __func__ << endl;
+    HexBoard board(7);
+    board.random_seed(1);
+    board.play(3, 3, player_X);
+
+    // O to move: ponder in the background until stopped.
+    UctSearch search(board, player_O, 50000, 2000);
+    atomic<bool> stop(false);
+    unsigned long nb_pondered = 0;
+    thread ponder_thread([&]() { nb_pondered = search.ponder(stop); });
+    this_thread::sleep_for(chrono::milliseconds(50));
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    stop = true;
+    ponder_thread.join();
+    chrono::duration<double, milli> cancel
+        = chrono::steady_clock::now() - start;
+    assert(cancel.count() < 10.0);
+    assert(nb_pondered > 0);
+    assert(search.root_visits_get() == nb_pondered);
+
+    // A search of the same position adds to the statistics of the
+    // pondering.
+    const pair<unsigned, unsigned> move = search.best_move_calculate();
+    assert(search.root_visits_get()
+           == nb_pondered + search.nb_simulations_get());
+
+    // Once a move is played, the next search starts from its subtree.
+    const unsigned long visits = search.root_visits_get();
+    board.play(move, player_O);
+    search.advance(move);
+    const unsigned long kept = search.root_visits_get();
+    assert((kept > 0) && (kept < visits));
+    search.best_move_calculate();
+    assert(search.root_visits_get() == kept + search.nb_simulations_get());
+
+    // Stopped before it starts: no iteration.
+    UctSearch stopped(board, player_X, 50000, 2000);
+    assert(stopped.ponder(stop) == 0);
+}
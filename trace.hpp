@@ -0,0 +1,170 @@
+/*------------------------------------------------------------------------------
+Instrumentation of the search: counters and phase timers, dumped per move
+trace.hpp
+------------------------------------------------------------------------------*/
+#ifndef TRACE_HPP_INCLUDED
+#define TRACE_HPP_INCLUDED
+
+// The instrumentation is compiled out unless HEX_TRACE is defined ("make
+// TRACE=1"): TRACE_COUNT() and TRACE_TIME() then expand to nothing, and the
+// functions below do nothing.
+//
+// Each thread counts in its own TraceCounters, without any synchronization.
+// trace_merge() adds them to the totals of the process, the threads of the
+// engines call it before they end. trace_dump() merges the counters of the
+// calling thread, writes the totals on one line and starts over: it is called
+// once per move, so that each line tells where the time of that move went.
+//
+// The timers add up the time of all the threads, the fill and win_check ones
+// include the overhead of reading the clock twice per call, some 10% of a
+// playout.
+
+#ifdef HEX_TRACE
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#endif
+
+struct TraceCounters {
+    // Playouts, i.e. fills of half the free slots.
+    unsigned long playouts;
+    // Win checks, in HexBoard::win_check() or in PlayoutBatch, and the steps
+    // of the comb of HexBoard::win_check() to the next and the previous rows.
+    unsigned long win_checks;
+    unsigned long comb_steps_down;
+    unsigned long comb_steps_up;
+    // Test moves that got simulations in MoveEvaluator.
+    unsigned long candidates;
+    // Evaluations ended by an immediate win, without any simulation.
+    unsigned long early_exits;
+    // Workers of MoveEvaluator stopped by the deadline.
+    unsigned long deadline_stops;
+
+    // Timers, in nanoseconds.
+    double fill_ns;
+    double win_check_ns;
+    // Phases of MoveEvaluator::best_move_calculate(): look for an immediate
+    // win, run the simulations, pick the best move.
+    double immediate_win_ns;
+    double simulations_ns;
+    double selection_ns;
+
+    void add(const TraceCounters& other) {
+        playouts += other.playouts;
+        win_checks += other.win_checks;
+        comb_steps_down += other.comb_steps_down;
+        comb_steps_up += other.comb_steps_up;
+        candidates += other.candidates;
+        early_exits += other.early_exits;
+        deadline_stops += other.deadline_stops;
+        fill_ns += other.fill_ns;
+        win_check_ns += other.win_check_ns;
+        immediate_win_ns += other.immediate_win_ns;
+        simulations_ns += other.simulations_ns;
+        selection_ns += other.selection_ns;
+    }
+};
+
+#ifdef HEX_TRACE
+
+// Counters of the calling thread.
+inline TraceCounters& trace_local()
+{
+    static thread_local TraceCounters counters = TraceCounters();
+    return counters;
+}
+
+// Adds the time from its construction to its destruction to a timer.
+class TraceTimer {
+public:
+    explicit TraceTimer(double& timer_ns):
+        timer_ns(timer_ns), start(std::chrono::steady_clock::now()) {}
+    ~TraceTimer() {
+        std::chrono::duration<double, std::nano> elapsed
+            = std::chrono::steady_clock::now() - start;
+        timer_ns += elapsed.count();
+    }
+
+private:
+    double& timer_ns;
+    const std::chrono::steady_clock::time_point start;
+};
+
+#define TRACE_COUNT(counter, n) (trace_local().counter += (n))
+#define TRACE_TIME(timer) \
+    TraceTimer trace_timer_##timer(trace_local().timer)
+
+struct TraceState {
+    std::mutex mutex;
+    TraceCounters totals;
+    std::ofstream file;
+};
+
+inline TraceState& trace_state()
+{
+    static TraceState state;
+    return state;
+}
+
+// Write the dumps to filename instead of the standard error.
+inline bool trace_output_open(const char* filename)
+{
+    TraceState& state = trace_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.file.open(filename);
+    return state.file.is_open();
+}
+
+inline void trace_merge()
+{
+    TraceState& state = trace_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.totals.add(trace_local());
+    trace_local() = TraceCounters();
+}
+
+// label identifies the line, the move for example.
+template <typename Label>
+inline void trace_dump(const Label& label)
+{
+    trace_merge();
+    TraceState& state = trace_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    std::ostream& os = state.file.is_open() ? state.file : std::cerr;
+    const TraceCounters& t = state.totals;
+    os << "trace " << label
+       << " playouts=" << t.playouts
+       << " win_checks=" << t.win_checks
+       << " comb_steps_down=" << t.comb_steps_down
+       << " comb_steps_up=" << t.comb_steps_up
+       << " candidates=" << t.candidates
+       << " early_exits=" << t.early_exits
+       << " deadline_stops=" << t.deadline_stops
+       << " fill_ms=" << t.fill_ns / 1e6
+       << " win_check_ms=" << t.win_check_ns / 1e6
+       << " immediate_win_ms=" << t.immediate_win_ns / 1e6
+       << " simulations_ms=" << t.simulations_ns / 1e6
+       << " selection_ms=" << t.selection_ns / 1e6
+       << std::endl;
+    state.totals = TraceCounters();
+}
+
+#else
+
+#define TRACE_COUNT(counter, n) ((void)0)
+#define TRACE_TIME(timer) ((void)0)
+
+inline bool trace_output_open(const char*)
+{
+    return false;
+}
+
+inline void trace_merge() {}
+
+template <typename Label>
+inline void trace_dump(const Label&) {}
+
+#endif // HEX_TRACE
+
+#endif // TRACE_HPP_INCLUDED
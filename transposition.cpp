@@ -0,0 +1,85 @@
+/*------------------------------------------------------------------------------
+Transposition table: simulation statistics per position
+transposition.cpp
+------------------------------------------------------------------------------*/
+#include "transposition.hpp"
+
+using namespace std;
+
+// Saturate rather than wrap around: halve both counts, keeping the win rate.
+static inline uint64_t data_make(uint64_t wins, uint64_t simulations,
+                                 const unsigned generation)
+{
+    while ((simulations > TranspositionTable::simulations_max)
+           || (wins > TranspositionTable::simulations_max)) {
+        wins /= 2;
+        simulations /= 2;
+    }
+    return (uint64_t(generation) << 56) | (wins << 28) | simulations;
+}
+
+static inline uint64_t data_wins_get(const uint64_t data)
+{
+    return (data >> 28) & TranspositionTable::simulations_max;
+}
+
+static inline uint64_t data_simulations_get(const uint64_t data)
+{
+    return data & TranspositionTable::simulations_max;
+}
+
+TranspositionTable::TranspositionTable(const size_t megabytes):
+    nb_entries(1), generation(0)
+{
+    const size_t bytes = megabytes * 1024 * 1024;
+    while (2 * nb_entries * sizeof(Entry) <= bytes) {
+        nb_entries *= 2;
+    }
+    entries.reset(new Entry[nb_entries]);
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i < nb_entries; ++i) {
+        entries[i].check.store(0, memory_order_relaxed);
+        entries[i].data.store(0, memory_order_relaxed);
+    }
+}
+
+bool TranspositionTable::probe(const uint64_t key,
+                               TranspositionStats& stats) const
+{
+    const Entry& entry = entry_get(key);
+    const uint64_t data = entry.data.load(memory_order_relaxed);
+    const uint64_t check = entry.check.load(memory_order_relaxed);
+    // An empty entry has no simulations, and is a miss for any key.
+    if (((check ^ data) != key) || (data_simulations_get(data) == 0)) {
+        return false;
+    }
+    stats.wins = data_wins_get(data);
+    stats.simulations = data_simulations_get(data);
+    return true;
+}
+
+void TranspositionTable::update(const uint64_t key, const uint32_t wins,
+                                const uint32_t simulations)
+{
+    Entry& entry = entry_get(key);
+    const uint64_t data = entry.data.load(memory_order_relaxed);
+    const uint64_t check = entry.check.load(memory_order_relaxed);
+
+    uint64_t new_data;
+    if ((check ^ data) == key) {
+        new_data = data_make(data_wins_get(data) + wins,
+                             data_simulations_get(data) + simulations,
+                             generation);
+    } else if (((data >> 56) != generation)
+               || (data_simulations_get(data) <= simulations)) {
+        new_data = data_make(wins, simulations, generation);
+    } else {
+        return;     // Keep the position with more simulations.
+    }
+    entry.data.store(new_data, memory_order_relaxed);
+    entry.check.store(key ^ new_data, memory_order_relaxed);
+}
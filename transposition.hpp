@@ -0,0 +1,87 @@
+/*------------------------------------------------------------------------------
+Transposition table: simulation statistics per position
+transposition.hpp
+------------------------------------------------------------------------------*/
+#ifndef TRANSPOSITION_HPP_INCLUDED
+#define TRANSPOSITION_HPP_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Wins and simulations of positions, keyed by HexBoard::hash_get() with the
+// player to move. As for the nodes of UctSearch, the wins are those of the
+// player who played the last move, i.e. not the player to move.
+//
+// The table has a fixed number of entries, a power of two, and never
+// allocates after construction. A key goes to a single entry, where it
+// replaces the previous key if it has at least as many simulations: the
+// positions seen the most stay. The entries are aged by generations, one per
+// search: an entry not updated in the current generation is replaced by any
+// other key, so that the positions of the previous moves of the game leave
+// room for those of the current search.
+//
+// Lock-free: the threads read and write the entries with relaxed atomics. An
+// entry stores its data, and its key xored with the data, so that a torn entry
+// (key of one write, data of another) does not match its key, and reads as a
+// miss (Hyatt and Mann's lockless hashing). Concurrent updates of the same
+// entry may lose some statistics, which only makes them a little less
+// precise.
+struct TranspositionStats {
+    uint32_t wins;
+    uint32_t simulations;
+};
+
+class TranspositionTable {
+public:
+    // Largest power of two number of entries that fits in megabytes, at least
+    // one entry.
+    explicit TranspositionTable(const size_t megabytes);
+
+    // Statistics of the position, false if not in the table.
+    bool probe(const uint64_t key, TranspositionStats& stats) const;
+
+    // Add simulation results to the statistics of the position. The counts
+    // saturate at simulations_max: both are halved, keeping the win rate.
+    void update(const uint64_t key, const uint32_t wins,
+                const uint32_t simulations);
+
+    // Start a new generation, before a search: the entries of the previous
+    // ones can still be probed, but any key replaces them. Not concurrently
+    // with the other functions.
+    void generation_next() {
+        generation = (generation + 1) & generation_mask;
+    }
+
+    void clear();
+
+    static const uint32_t simulations_max = (1u << 28) - 1;
+
+    size_t nb_entries_get() const {
+        return nb_entries;
+    }
+
+    size_t memory_size_get() const {
+        return nb_entries * sizeof(Entry);
+    }
+
+protected:
+    struct Entry {
+        std::atomic<uint64_t> check;    // key ^ data
+        // generation << 56 | wins << 28 | simulations
+        std::atomic<uint64_t> data;
+    };
+
+    static const unsigned generation_mask = 0xff;
+
+    size_t nb_entries;
+    unsigned generation;
+    std::unique_ptr<Entry[]> entries;
+
+    Entry& entry_get(const uint64_t key) const {
+        return entries[key & (nb_entries - 1)];
+    }
+};
+
+#endif // TRANSPOSITION_HPP_INCLUDED
@@ -0,0 +1,457 @@
+/*------------------------------------------------------------------------------
+UCT tree search for Hex
+uctsearch.cpp
+------------------------------------------------------------------------------*/
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include <utility>
+
+#include "hexboard.hpp"
+#include "trace.hpp"
+#include "uctsearch.hpp"
+
+using namespace std;
+
+const uint32_t UctNodePool::full_index;
+
+// Weight of the exploration term in UCB1.
+static const double exploration = 0.25;
+
+// A leaf is expanded once it has been visited this many times. Expanding
+// earlier costs a lot of memory for nodes that are visited only once.
+static const unsigned expand_threshold = 8;
+
+// Number of iterations between two checks of the deadline.
+static const unsigned batch_size = 128;
+
+// Upper limit to the size of the tree, in nodes. The trees of a ROOT search
+// share it.
+static const size_t max_nb_nodes = 4000000;
+
+// The statistics of the nodes are shared by the threads of a TREE search.
+// They are read and written with relaxed atomic operations, so that the
+// nodes stay plain structures that the pool copies. The children of a node
+// are published by storing their number last, with release semantics.
+template <typename T>
+static inline T relaxed_load(const T& value)
+{
+    return __atomic_load_n(&value, __ATOMIC_RELAXED);
+}
+
+static inline void relaxed_increment(uint32_t& value)
+{
+    __atomic_fetch_add(&value, 1, __ATOMIC_RELAXED);
+}
+
+static inline uint16_t nb_children_get(const UctNode& node)
+{
+    return __atomic_load_n(&node.nb_children, __ATOMIC_ACQUIRE);
+}
+
+UctSearch::UctSearch(HexBoard& base_board,
+                     const Player current_player,
+                     const unsigned max_nb_simulations,
+                     const unsigned max_nb_simulations_per_test):
+    board(base_board),
+    root_player(current_player),
+    max_nb_total_simulations(max_nb_simulations),
+    max_nb_simulations_per_test(max_nb_simulations_per_test),
+    nb_simulations_run(0),
+    best_score(0.0),
+    nb_threads(1),
+    parallel(UctParallel::TREE),
+    deadline(chrono::steady_clock::time_point::max()),
+    transpositions(nullptr),
+    expand_mutex(new mutex)
+{
+    // Drawn from the original board, so that seeding it makes the search
+    // reproducible.
+    board.random_seed(base_board.random_draw());
+}
+
+pair<unsigned, unsigned> UctSearch::best_move_calculate()
+{
+    const vector< pair<unsigned, unsigned> > free_slots
+                  = board.unoccupied_list_get();
+
+    // Look for an immediate win first, no need to search then.
+    for (auto test_coord: free_slots) {
+        bool win = board.play(test_coord, root_player);
+        board.unplace(test_coord);
+        if (win) {
+            best_score = 1.0;
+            return test_coord;
+        }
+    }
+
+    // Same budget as the flat Monte-Carlo evaluation, but spent where the
+    // tree leads instead of evenly on all test moves.
+    unsigned long nb_simulations_per_move = max_nb_total_simulations
+        / free_slots.size();
+    if (nb_simulations_per_move > max_nb_simulations_per_test) {
+        nb_simulations_per_move = max_nb_simulations_per_test;
+    }
+    const unsigned long nb_simulations = nb_simulations_per_move
+        * free_slots.size();
+
+    tree_prepare(nodes_needed_get(nb_simulations, free_slots.size()),
+                 max_nb_nodes);
+
+    const unsigned n = max(nb_threads, 1u);
+    // Share of the simulations of thread i, the calling thread is thread 0.
+    auto share = [&](const unsigned i) {
+        return nb_simulations / n + (i < nb_simulations % n);
+    };
+    vector<unsigned long> nb_run(n, 0);
+    // Visits and wins of the moves at the root, over all the trees.
+    vector<unsigned long> visits(board.size_get() * board.size_get(), 0);
+    vector<unsigned long> wins(visits.size(), 0);
+    if (n == 1) {
+        nb_run[0] = iterations_run(board, path, nb_simulations, false);
+    } else if (parallel == UctParallel::TREE) {
+        // The boards of the threads, seeded from that of the search.
+        vector<HexBoard> boards(n - 1, board);
+        vector<UctPath> paths(n - 1);
+        vector<thread> workers;
+        for (unsigned i = 1; i < n; ++i) {
+            boards[i - 1].random_seed(board.random_draw());
+            workers.push_back(thread([&, i]() {
+                nb_run[i] = iterations_run(boards[i - 1], paths[i - 1],
+                                           share(i), true);
+                // The counters of the worker threads go with them.
+                trace_merge();
+            }));
+        }
+        nb_run[0] = iterations_run(board, path, share(0), true);
+        for (auto& worker: workers) {
+            worker.join();
+        }
+    } else {
+        // New searches with the settings of this one, on copies of the
+        // board seeded from it.
+        vector< unique_ptr<UctSearch> > searches;
+        vector<thread> workers;
+        for (unsigned i = 1; i < n; ++i) {
+            searches.emplace_back(new UctSearch(board, root_player,
+                                                max_nb_total_simulations,
+                                                max_nb_simulations_per_test));
+            UctSearch* search = searches.back().get();
+            search->transposition_table_set(transpositions);
+            search->deadline_set(deadline);
+            workers.push_back(thread([&, i, search]() {
+                search->tree_prepare(
+                    search->nodes_needed_get(share(i), free_slots.size()),
+                    max_nb_nodes / n);
+                nb_run[i] = search->iterations_run(search->board,
+                                                   search->path, share(i),
+                                                   false);
+                trace_merge();
+            }));
+        }
+        nb_run[0] = iterations_run(board, path, share(0), false);
+        for (auto& worker: workers) {
+            worker.join();
+        }
+        for (auto& search: searches) {
+            search->root_visits_add(visits, wins);
+        }
+    }
+    root_visits_add(visits, wins);
+    nb_simulations_run = 0;
+    for (auto nb: nb_run) {
+        nb_simulations_run += nb;
+    }
+
+    // The most visited move is the most robust choice.
+    const UctNode& root = pool[0];
+    uint32_t best = root.first_child;
+    for (uint32_t i = root.first_child;
+         i < root.first_child + root.nb_children;
+         ++i) {
+        if (visits[pool[i].move] > visits[pool[best].move]) {
+            best = i;
+        }
+    }
+
+    // The wins of a child are those of the player who played its move.
+    const unsigned best_move = pool[best].move;
+    best_score = (visits[best_move] > 0) ?
+        static_cast<double>(wins[best_move]) / visits[best_move] : 0.0;
+
+    const unsigned size = board.size_get();
+    return make_pair(pool[best].move % size, pool[best].move / size);
+}
+
+size_t UctSearch::nodes_needed_get(const unsigned long nb_simulations,
+                                   const unsigned nb_moves) const
+{
+    // With a deadline, the number of simulations is not known.
+    const bool timed = (deadline != chrono::steady_clock::time_point::max());
+    return timed ? max_nb_nodes
+        : 1 + (nb_simulations / expand_threshold + 1) * nb_moves;
+}
+
+void UctSearch::tree_prepare(const size_t nb_new_nodes, const size_t max_nodes)
+{
+    // Room for the new nodes, on top of the ones kept from the previous
+    // searches.
+    if (pool.size() < max_nodes) {
+        pool.reserve_more(min(max_nodes - pool.size(), nb_new_nodes));
+    }
+    if (pool.size() == 0) {
+        pool.allocate(1);   // Root, index 0.
+    }
+    if (pool[0].nb_children == 0) {
+        expand(board, path, 0, root_player, false);
+    }
+}
+
+unsigned long UctSearch::iterations_run(HexBoard& thread_board,
+                                        UctPath& thread_path,
+                                        const unsigned long nb_iterations,
+                                        const bool shared)
+{
+    if (deadline == chrono::steady_clock::time_point::max()) {
+        for (unsigned long i = 0; i < nb_iterations; ++i) {
+            iteration_run(thread_board, thread_path, shared);
+        }
+        return nb_iterations;
+    }
+    unsigned long nb_run = 0;
+    do {
+        for (unsigned i = 0; i < batch_size; ++i) {
+            iteration_run(thread_board, thread_path, shared);
+        }
+        nb_run += batch_size;
+    } while (chrono::steady_clock::now() < deadline);
+    return nb_run;
+}
+
+void UctSearch::root_visits_add(vector<unsigned long>& visits,
+                                vector<unsigned long>& wins)
+{
+    const UctNode& root = pool[0];
+    for (uint32_t i = root.first_child;
+         i < root.first_child + root.nb_children;
+         ++i) {
+        visits[pool[i].move] += pool[i].visits;
+        wins[pool[i].move] += pool[i].wins;
+    }
+}
+
+unsigned long UctSearch::ponder(const atomic<bool>& stop)
+{
+    if (board.unoccupied_list_get().empty()) {
+        return 0;
+    }
+    // The number of iterations is not known, as with a deadline.
+    tree_prepare(max_nb_nodes, max_nb_nodes);
+    unsigned long nb_run = 0;
+    while (!stop.load(memory_order_relaxed)) {
+        iteration_run(board, path, false);
+        ++nb_run;
+    }
+    return nb_run;
+}
+
+void UctSearch::advance(const pair<unsigned, unsigned> move)
+{
+    board.place(move, root_player);
+    root_player.swap();
+
+    const uint16_t lin = move.second * board.size_get() + move.first;
+    if (pool.size() > 0) {
+        const UctNode& root = pool[0];
+        for (uint32_t i = root.first_child;
+             i < root.first_child + root.nb_children;
+             ++i) {
+            if (pool[i].move == lin) {
+                subtree_keep(i);
+                return;
+            }
+        }
+    }
+    // Not in the tree, start over.
+    pool.reset(0);
+}
+
+void UctSearch::subtree_keep(const uint32_t node_index)
+{
+    // The subtree cannot be larger than the current tree.
+    spare_pool.reset(pool.size());
+
+    // Breadth first copy, children blocks stay contiguous. Each entry is the
+    // index of a node in the old pool, and of its copy in the new one.
+    vector< pair<uint32_t, uint32_t> > queue;
+    spare_pool.allocate(1);
+    spare_pool[0] = pool[node_index];
+    queue.push_back(make_pair(node_index, 0));
+    for (size_t q = 0; q < queue.size(); ++q) {
+        const UctNode& old_node = pool[queue[q].first];
+        if (old_node.nb_children == 0) {
+            continue;
+        }
+        uint32_t first = spare_pool.allocate(old_node.nb_children);
+        spare_pool[queue[q].second].first_child = first;
+        for (unsigned i = 0; i < old_node.nb_children; ++i) {
+            spare_pool[first + i] = pool[old_node.first_child + i];
+            queue.push_back(make_pair(old_node.first_child + i, first + i));
+        }
+    }
+    pool.swap(spare_pool);
+}
+
+bool UctSearch::expand(HexBoard& thread_board, UctPath& thread_path,
+                       const uint32_t node_index, const Player player,
+                       const bool shared)
+{
+    unique_lock<mutex> lock;
+    if (shared) {
+        lock = unique_lock<mutex>(*expand_mutex);
+        // Another thread may have expanded the node in the meantime.
+        if (nb_children_get(pool[node_index]) > 0) {
+            return true;
+        }
+    }
+
+    // The inferior slots get no node, when the board uses them.
+    vector< pair<unsigned, unsigned> >& free_slots = thread_path.moves;
+    free_slots = thread_board.unoccupied_list_get();
+    thread_board.inferior_slots_remove(free_slots);
+    const unsigned size = thread_board.size_get();
+
+    uint32_t first = pool.allocate(free_slots.size());
+    if (first == UctNodePool::full_index) {
+        return false;
+    }
+    for (unsigned i = 0; i < free_slots.size(); ++i) {
+        UctNode& child = pool[first + i];
+        child.move = free_slots[i].second * size + free_slots[i].first;
+        TranspositionStats stats;
+        if ((transpositions != nullptr)
+            && transpositions->probe(
+                thread_board.canonical_hash_after_get(free_slots[i], player),
+                stats)) {
+            child.visits = stats.simulations;
+            child.wins = stats.wins;
+        }
+    }
+    pool[node_index].first_child = first;
+    __atomic_store_n(&pool[node_index].nb_children, free_slots.size(),
+                     __ATOMIC_RELEASE);
+    return true;
+}
+
+uint32_t UctSearch::child_select(const uint32_t node_index)
+{
+    const UctNode& node = pool[node_index];
+    const double log_visits = log(relaxed_load(node.visits) + 1);
+
+    uint32_t best = node.first_child;
+    double best_value = -1.0;
+    for (uint32_t i = node.first_child;
+         i < node.first_child + node.nb_children;
+         ++i) {
+        const UctNode& child = pool[i];
+        const uint32_t visits = relaxed_load(child.visits);
+        if (visits == 0) {
+            return i;
+        }
+        double value = static_cast<double>(relaxed_load(child.wins)) / visits
+            + exploration * sqrt(log_visits / visits);
+        if (value > best_value) {
+            best_value = value;
+            best = i;
+        }
+    }
+    return best;
+}
+
+void UctSearch::iteration_run(HexBoard& thread_board, UctPath& thread_path,
+                              const bool shared)
+{
+    const unsigned size = thread_board.size_get();
+    Player player = root_player;  // Next player to place a stone.
+    uint32_t node_index = 0;
+
+    const bool keyed = (transpositions != nullptr);
+    vector<uint32_t>& nodes = thread_path.nodes;
+    vector<uint64_t>& keys = thread_path.keys;
+
+    nodes.clear();
+    nodes.push_back(node_index);
+    keys.clear();
+    if (keyed) {
+        keys.push_back(thread_board.canonical_hash_get(player));
+    }
+    // With virtual loss, the visits are counted on the way down, the wins
+    // on the way up.
+    if (shared) {
+        relaxed_increment(pool[node_index].visits);
+    }
+
+    // Selection: go down the tree, playing the moves on the board.
+    while (nb_children_get(pool[node_index]) > 0) {
+        node_index = child_select(node_index);
+        if (shared) {
+            relaxed_increment(pool[node_index].visits);
+        }
+        const uint16_t move = pool[node_index].move;
+        thread_board.place(move % size, move / size, player);
+        nodes.push_back(node_index);
+        player.swap();
+        if (keyed) {
+            keys.push_back(thread_board.canonical_hash_get(player));
+        }
+    }
+
+    // Expansion, once the leaf has been visited enough. A leaf can be a full
+    // board.
+    if ((relaxed_load(pool[node_index].visits) >= expand_threshold)
+        && !thread_board.unoccupied_list_get().empty()
+        && expand(thread_board, thread_path, node_index, player, shared)) {
+        node_index = child_select(node_index);
+        if (shared) {
+            relaxed_increment(pool[node_index].visits);
+        }
+        const uint16_t move = pool[node_index].move;
+        thread_board.place(move % size, move / size, player);
+        nodes.push_back(node_index);
+        player.swap();
+        if (keyed) {
+            keys.push_back(thread_board.canonical_hash_get(player));
+        }
+    }
+
+    // Playout, for the player who placed the last stone. If that player
+    // already won in the tree, the filled up board keeps that win.
+    player.swap();
+    thread_board.player_select(player);
+    thread_board.occupied_save();
+    bool win = thread_board.fill_up_half_and_win_check();
+    thread_board.occupied_restore();
+
+    // Back propagation. The statistics of each node are seen from the player
+    // who played its move, that alternates going up.
+    for (size_t i = nodes.size(); i-- > 0; ) {
+        UctNode& node = pool[nodes[i]];
+        if (!shared) {
+            relaxed_increment(node.visits);
+        }
+        if (win) {
+            relaxed_increment(node.wins);
+        }
+        if (keyed) {
+            transpositions->update(keys[i], win, 1);
+        }
+        win = !win;
+    }
+
+    // Take back the moves of the tree, last first. The root has no move.
+    for (size_t i = nodes.size() - 1; i > 0; --i) {
+        const uint16_t move = pool[nodes[i]].move;
+        thread_board.unplace(move % size, move / size);
+    }
+}
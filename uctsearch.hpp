@@ -0,0 +1,280 @@
+/*------------------------------------------------------------------------------
+UCT tree search for Hex
+uctsearch.hpp
+------------------------------------------------------------------------------*/
+#ifndef UCTSEARCH_HPP_INCLUDED
+#define UCTSEARCH_HPP_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "hexboard.hpp"
+#include "transposition.hpp"
+
+// A node of the search tree. The statistics are seen from the player who
+// played the move leading to the node.
+struct UctNode {
+    uint32_t visits;
+    uint32_t wins;
+    // Index of the first child in the node pool, the children of a node are
+    // contiguous. 0 if the node was not expanded (the root is at index 0, and
+    // is nobody's child).
+    uint32_t first_child;
+    uint16_t nb_children;
+    // Move leading to this node, as a linear index (row * size + col).
+    uint16_t move;
+};
+
+// Arena for the nodes of the tree. Nodes are allocated in blocks (all the
+// children of a node at once) from a single vector whose capacity is reserved
+// up front, so that it never reallocates and references to nodes stay valid.
+// All the nodes are freed at once by reset().
+class UctNodePool {
+public:
+    UctNodePool(): capacity(0) {}
+
+    // Free all nodes, and make room for capacity nodes.
+    void reset(const size_t capacity) {
+        nodes.clear();
+        nodes.reserve(capacity);
+        this->capacity = capacity;
+    }
+
+    // Keep the nodes, and make room for nb more. This may move the nodes,
+    // references to them are not valid any more.
+    void reserve_more(const size_t nb) {
+        capacity = nodes.size() + nb;
+        nodes.reserve(capacity);
+    }
+
+    // Allocate nb contiguous nodes, return the index of the first one, or
+    // full_index if the pool is full.
+    uint32_t allocate(const unsigned nb) {
+        if (nodes.size() + nb > capacity) {
+            return full_index;
+        }
+        uint32_t first = nodes.size();
+        nodes.resize(nodes.size() + nb);
+        return first;
+    }
+
+    UctNode& operator[](const uint32_t index) {
+        return nodes[index];
+    }
+
+    size_t size() const {
+        return nodes.size();
+    }
+
+    void swap(UctNodePool& other) {
+        nodes.swap(other.nodes);
+        std::swap(capacity, other.capacity);
+    }
+
+    static const uint32_t full_index = UINT32_MAX;
+
+private:
+    vector<UctNode> nodes;
+    size_t capacity;
+};
+
+// How the threads of a search share the work, see UctSearch::parallel_set().
+enum class UctParallel { TREE, ROOT };
+
+// Nodes of the current iteration of a thread, from the root, with the hash of
+// their positions when there is a transposition table, and the scratch list
+// of moves of UctSearch::expand().
+struct UctPath {
+    vector<uint32_t> nodes;
+    vector<uint64_t> keys;
+    vector< pair<unsigned, unsigned> > moves;
+};
+
+class UctSearch {
+public:
+    // Same parameters as MoveEvaluator, the total number of simulations is
+    // computed in the same way, to compare both at equal playout counts.
+    // The search runs on its own copy of base_board, which is then kept up to
+    // date with advance(). The tree is kept between searches.
+    UctSearch(HexBoard& base_board,
+              const Player current_player,
+              const unsigned max_nb_simulations = 100000u,
+              const unsigned max_nb_simulations_per_test = 2000u);
+
+    // Run the search for the player to move and return the most visited move
+    // at the root. The simulations are added to the statistics already in the
+    // tree.
+    pair<unsigned, unsigned> best_move_calculate();
+
+    // Search the current position, for the player to move, until stop is
+    // set, then return the number of iterations run. stop is checked after
+    // each iteration, a few microseconds. Meant to run in a thread of its
+    // own while the other player thinks (pondering): the search must not be
+    // used otherwise until it returns. advance() then keeps the subtree of
+    // the move played, with the statistics of the pondering, and the next
+    // best_move_calculate() adds its simulations to them.
+    unsigned long ponder(const atomic<bool>& stop);
+
+    // A move was played in the game, by the player to move. The subtree of
+    // that move becomes the new tree with its statistics, the rest is
+    // dropped.
+    void advance(const pair<unsigned, unsigned> move);
+
+    // Run simulations until the deadline instead of a fixed number of them.
+    // The simulations run in batches, the deadline is checked after each
+    // batch. time_point::max() goes back to a fixed number of simulations.
+    void deadline_set(const chrono::steady_clock::time_point t) {
+        deadline = t;
+    }
+
+    // Number of threads of the search, 1 by default.
+    void threads_set(const unsigned n) {
+        nb_threads = n;
+    }
+
+    // With several threads:
+    // - TREE, the default: all the threads go down the same tree, each with
+    //   its own board. A thread going down a node counts a visit at once, as
+    //   a loss until its playout says otherwise (virtual loss), so that the
+    //   others spread over other moves. The statistics of the nodes are
+    //   updated with relaxed atomic operations, and expansions take a lock.
+    //   Which thread goes down which node depends on their timing, so the
+    //   results are not reproducible, even with a seed.
+    // - ROOT: each thread searches a tree of its own, from the same
+    //   position, and the visits of the moves at the roots are added up at
+    //   the end. Only the tree of the calling thread is kept for the next
+    //   search. Reproducible with a seed, a number of simulations and a
+    //   number of threads: the threads split the simulations between their
+    //   trees.
+    // The simulations are split evenly between the threads, or all run
+    // until the deadline.
+    void parallel_set(const UctParallel mode) {
+        parallel = mode;
+    }
+
+    // Share the statistics of the positions through a transposition table:
+    // new nodes start from the statistics of their position in the table, and
+    // every simulation is added to the table for all the positions on its
+    // path. Positions reached by different move orders thus share their
+    // simulations. nullptr, the default, for none.
+    void transposition_table_set(TranspositionTable* table) {
+        transpositions = table;
+    }
+
+    // Policy of the playouts, see HexBoard::playout_policy_select(). That of
+    // base_board by default.
+    void playout_policy_set(const PlayoutPolicy policy) {
+        board.playout_policy_select(policy);
+    }
+
+    // Use the inferior slots of the positions, see
+    // HexBoard::inferior_slots_use(): the nodes have no children for them,
+    // and the playouts pre-fill them. Those of base_board by default.
+    void inferior_slots_use(const bool enable) {
+        board.inferior_slots_use(enable);
+    }
+
+    // Number of simulations through the root, including the ones inherited
+    // from previous searches.
+    unsigned long root_visits_get() {
+        return (pool.size() > 0) ? pool[0].visits : 0;
+    }
+
+    // Number of simulations run by the last call to best_move_calculate().
+    unsigned long nb_simulations_get() const {
+        return nb_simulations_run;
+    }
+
+    // Win rate of the move returned by the last call to
+    // best_move_calculate(), in the tree of the calling thread, 1 for an
+    // immediate win. Same meaning as MoveEvaluator::best_score_get().
+    double best_score_get() const {
+        return best_score;
+    }
+
+    // Budget of the next searches, as in the constructor. The tree is kept.
+    void simulations_set(const unsigned max_nb_simulations,
+                         const unsigned max_nb_simulations_per_test) {
+        max_nb_total_simulations = max_nb_simulations;
+        this->max_nb_simulations_per_test = max_nb_simulations_per_test;
+    }
+
+protected:
+    HexBoard board;
+
+    // Player to move at the root.
+    Player root_player;
+
+    unsigned max_nb_total_simulations;
+    unsigned max_nb_simulations_per_test;
+    unsigned long nb_simulations_run;
+    double best_score;
+
+    unsigned nb_threads;
+    UctParallel parallel;
+
+    chrono::steady_clock::time_point deadline;
+
+    UctNodePool pool;
+    // Destination of the subtree kept by advance(), swapped with pool.
+    UctNodePool spare_pool;
+
+    TranspositionTable* transpositions;
+
+    // Path of the calling thread. The stones placed on board while going
+    // down the tree are undone after the simulation.
+    UctPath path;
+
+    // Taken by the expansions of a TREE search with several threads. On the
+    // heap, for the search to stay movable.
+    unique_ptr<mutex> expand_mutex;
+
+    // Nodes that nb_simulations more may add to the tree, with nb_moves moves
+    // at the root. As many as the tree may hold with a deadline.
+    size_t nodes_needed_get(const unsigned long nb_simulations,
+                            const unsigned nb_moves) const;
+
+    // Make room in the pool for nb_new_nodes more, up to max_nodes nodes,
+    // and expand the root.
+    void tree_prepare(const size_t nb_new_nodes, const size_t max_nodes);
+
+    // Create the children of a node, one per unoccupied slot of
+    // thread_board but the inferior ones, for player to move. Return false
+    // if the pool is full. shared as for iteration_run().
+    bool expand(HexBoard& thread_board, UctPath& thread_path,
+                const uint32_t node_index, const Player player,
+                const bool shared);
+
+    // UCB1 selection among the children of a node. Unvisited children go
+    // first.
+    uint32_t child_select(const uint32_t node_index);
+
+    // One iteration on thread_board: selection, expansion, playout and back
+    // propagation. shared if other threads go down the same tree, with
+    // virtual loss.
+    void iteration_run(HexBoard& thread_board, UctPath& thread_path,
+                       const bool shared);
+
+    // Run nb_iterations iterations, or batches of them until the deadline.
+    // Return the number run.
+    unsigned long iterations_run(HexBoard& thread_board,
+                                 UctPath& thread_path,
+                                 const unsigned long nb_iterations,
+                                 const bool shared);
+
+    // Add the visits and the wins of each move at the root, indexed by linear
+    // index, to visits and wins.
+    void root_visits_add(vector<unsigned long>& visits,
+                         vector<unsigned long>& wins);
+
+    // Copy the subtree under node_index to spare_pool, with node_index as its
+    // root, and make it the tree.
+    void subtree_keep(const uint32_t node_index);
+};
+
+#endif // UCTSEARCH_HPP_INCLUDED